@@ -169,13 +169,14 @@ int obDetectorId;
 
 void GameClientImplementation::RegisterClientComponents()
 {
-    secs::ComponentRegistry::registerType<Spin>("Spin");
+    // Markers that get toggled at runtime are sparse, so adding one doesn't drag the Transform along
+    secs::ComponentRegistry::registerType<Spin>("Spin", secs::StorageKind::Sparse);
     secs::ComponentRegistry::registerType<Manipulator>("Manipulator");
     secs::ComponentRegistry::registerType<HelloWorldComponent>("HelloWorldComponent");
-    secs::ComponentRegistry::registerType<OutOfBoundsDetector>("OutOfBoundsDetector");
+    secs::ComponentRegistry::registerType<OutOfBoundsDetector>("OutOfBoundsDetector", secs::StorageKind::Sparse);
     secs::ComponentRegistry::registerType<Car>("Car");
     secs::ComponentRegistry::registerType<GroundMesh>("GroundMesh");
-    secs::ComponentRegistry::registerType<ModelViewer>("ModelViewer");
+    secs::ComponentRegistry::registerType<ModelViewer>("ModelViewer", secs::StorageKind::Sparse);
     secs::ComponentRegistry::registerType<Name>("Name");
 
 }
@@ -184,131 +185,131 @@ bool isGameOver = true;
 
 void GameClientImplementation::RegisterClientSystems()
 {
-    int spinTypeId = secs::ComponentRegistry::getID<Spin>();
-    int transformTypeId = secs::ComponentRegistry::getID<Transform>();
-    int manipulatorTypeId = secs::ComponentRegistry::getID<Manipulator>();
-
-
     // SpinTransformSystem
-    secs::System spinTransformSystem(
-        {spinTypeId, transformTypeId},
-        [spinTypeId, transformTypeId](secs::Entity e, secs::World& w)
+    Engine::AddSystem(secs::makeParallelSystem<const Spin, Transform>(
+        "SpinTransform",
+        [](const secs::Entity*, const Spin* spins, Transform* transforms, size_t count)
         {
-            auto* spin = w.getComponent<Spin>(e);
-            auto* transform = w.getComponent<Transform>(e);
-            transform->RotateAroundAxis(glm::vec3(0, 1, 0), spin->rotateSpeed * Engine::deltaTime);
-            transform->position.y += Engine::deltaTime;
+            for (size_t i = 0; i < count; ++i)
+            {
+                transforms[i].RotateAroundAxis(glm::vec3(0, 1, 0), spins[i].rotateSpeed * Engine::deltaTime);
+                transforms[i].position.y += Engine::deltaTime;
+            }
         }
-    );
-    Engine::AddSystem(spinTransformSystem);
-    auto carTypeId = secs::ComponentRegistry::getID<Car>();
-    auto aaBbTypeId = secs::ComponentRegistry::getID<AABB>();
-    secs::System carSystem(
-        {carTypeId, transformTypeId, aaBbTypeId},
-        [&](secs::Entity carEntity, secs::World& w)
+    ));
+
+    // Every car asks the grid what's around it instead of testing every obstacle. Read-only, so the
+    // obstacles don't count as changed and their model matrices aren't rebuilt.
+    // Cars are skipped, so a car never hits itself. The obstacles' components are read off other
+    // entities, outside the system's own rows, so they're declared for the scheduler.
+    obstacles = std::make_unique<SpatialIndex>(world);
+    Engine::AddSystem(secs::makeSystem<Car, Transform, const AABB>(
+        "Car",
+        [this](const secs::Entity*, Car* cars, Transform* carTransforms, const AABB* carAabbs, size_t carCount)
         {
-            auto car = w.getComponent<Car>(carEntity);
-            auto carTrans = w.getComponent<Transform>(carEntity);
-
-            // 1) Move the car in its forward direction by current speed
-            //    We'll treat speed as units per second. 
-            carTrans->position += carTrans->GetDirection() * car->speed * Engine::deltaTime;
-
-            // 2) Apply turning *based on speed*
-            //    - The faster you go, the more sensitive (or the other way around if you prefer).
-            //    - Example: turnAngle = turnInput * turnSpeed * (car->speed / maxSpeed).
-            float normalizedSpeed = car->speed / car->maxSpeed;
-            float turnAngle = car->turnInput
-                * car->turnSpeed
-                * normalizedSpeed
-                * Engine::deltaTime; // scale by deltatime
-            if (fabs(car->turnInput) > 0.001f && fabs(car->speed) > 0.01f)
+            std::vector<secs::Entity> nearby;
+            for (size_t c = 0; c < carCount; ++c)
             {
-                carTrans->RotateAroundAxis(glm::vec3(0, 1, 0), turnAngle);
-            }
+                Car* car = &cars[c];
+                Transform* carTrans = &carTransforms[c];
+                const AABB* carAabb = &carAabbs[c];
+
+                // 1) Move the car in its forward direction by current speed
+                //    We'll treat speed as units per second. 
+                carTrans->position += carTrans->GetDirection() * car->speed * Engine::deltaTime;
+
+                // 2) Apply turning *based on speed*
+                //    - The faster you go, the more sensitive (or the other way around if you prefer).
+                //    - Example: turnAngle = turnInput * turnSpeed * (car->speed / maxSpeed).
+                float normalizedSpeed = car->speed / car->maxSpeed;
+                float turnAngle = car->turnInput
+                    * car->turnSpeed
+                    * normalizedSpeed
+                    * Engine::deltaTime; // scale by deltatime
+                if (fabs(car->turnInput) > 0.001f && fabs(car->speed) > 0.01f)
+                {
+                    carTrans->RotateAroundAxis(glm::vec3(0, 1, 0), turnAngle);
+                }
 
-            // 3) If not accelerating, apply friction
-            if (!car->accelerating)
-            {
-                // MoveTowards is a linear movement, you might want to do something else for friction
-                car->speed = MathUtils::MoveTowards(car->speed, 0.0f, Engine::deltaTime * 2.0f);
-            }
-            car->turnInput = glm::mix(car->turnInput, 0.0f, 3 * Engine::deltaTime);
-            // Reset accelerating flag for next frame
-            car->accelerating = false;
-            auto* carAabb = w.getComponent<AABB>(carEntity);
-
-            secs::queryChunks<Transform, AABB>(
-                world, // Pass the World instance as the first parameter
-                [carEntity, car, carAabb, carTrans](const std::vector<secs::Entity>& ents,
-                    const Transform* transforms,
-                    const AABB* aabbs,
-                    const size_t count)
+                // 3) If not accelerating, apply friction
+                if (!car->accelerating)
+                {
+                    // MoveTowards is a linear movement, you might want to do something else for friction
+                    car->speed = MathUtils::MoveTowards(car->speed, 0.0f, Engine::deltaTime * 2.0f);
+                }
+                car->turnInput = glm::mix(car->turnInput, 0.0f, 3 * Engine::deltaTime);
+                // Reset accelerating flag for next frame
+                car->accelerating = false;
+
+                nearby.clear();
+                obstacles->Query(PEPhysics::TransformAABBToWorld(*carAabb, *carTrans), nearby);
+                for (secs::Entity other : nearby)
                 {
-                    for (size_t i = 0; i < count; i++)
+                    const Transform* transform = world.getComponent<const Transform>(other);
+                    const AABB* aabb = world.getComponent<const AABB>(other);
+                    if (!transform || !aabb || world.getComponent<const Car>(other))
+                        continue;
+                    bool hit = PEPhysics::CheckAABBOverlap(*aabb, *transform, *carAabb, *carTrans);
+                    if (hit)
                     {
-                        if (ents[i].id == carEntity.id)
-                            continue;
-                        bool hit = PEPhysics::CheckAABBOverlap(aabbs[i], transforms[i], *carAabb, *carTrans);
-                        if (hit)
-                        {
-                             
-                            carTrans->position -= carTrans->GetDirection() * glm::sign(car->speed);
-                            car->speed = 0;
+                         
+                        carTrans->position -= carTrans->GetDirection() * glm::sign(car->speed);
+                        car->speed = 0;
 #if PE_DEBUG
-                            std::cout << "car hit " << ents[i].id << std::endl;
+                        std::cout << "car hit " << other.id << std::endl;
 #endif
-                        }
                     }
-                });
+                }
+            }
         }
-    );
-    Engine::AddSystem(carSystem);
+    ).alsoReads<Transform>().alsoReads<AABB>().alsoReads<Car>());
 
     // ManipulatorTransformSystem
-    secs::System manipulatorTransformSystem(
-        {manipulatorTypeId, transformTypeId},
-        [manipulatorTypeId, transformTypeId](secs::Entity e, secs::World& w)
+    Engine::AddSystem(secs::makeSystem<const Manipulator, Transform>(
+        "ManipulatorTransform",
+        [](const secs::Entity*, const Manipulator* manipulators, Transform* transforms, size_t count)
         {
-            auto* manipulator = w.getComponent<Manipulator>(e);
-            auto* transform = w.getComponent<Transform>(e);
-
-            // Movement controls
-            if (Engine::IsKeyPressed(SDLK_w)) { transform->position.z -= manipulator->moveSpeed * Engine::deltaTime; }
-            if (Engine::IsKeyPressed(SDLK_s)) { transform->position.z += manipulator->moveSpeed * Engine::deltaTime; }
-            if (Engine::IsKeyPressed(SDLK_a)) { transform->position.x -= manipulator->moveSpeed * Engine::deltaTime; }
-            if (Engine::IsKeyPressed(SDLK_d)) { transform->position.x += manipulator->moveSpeed * Engine::deltaTime; }
-            if (Engine::IsKeyPressed(SDLK_z)) { transform->position.y -= manipulator->moveSpeed * Engine::deltaTime; }
-            if (Engine::IsKeyPressed(SDLK_x)) { transform->position.y += manipulator->moveSpeed * Engine::deltaTime; }
-
-            // Rotation controls
-            if (Engine::IsKeyPressed(SDLK_UP))
-            {
-                transform->RotateAroundAxis(glm::vec3(-1, 0, 0), Engine::deltaTime);
-            }
-            if (Engine::IsKeyPressed(SDLK_DOWN))
-            {
-                transform->RotateAroundAxis(glm::vec3(1, 0, 0), Engine::deltaTime);
-            }
-            if (Engine::IsKeyPressed(SDLK_LEFT))
-            {
-                transform->RotateAroundAxis(glm::vec3(0, -1, 0), Engine::deltaTime);
-            }
-            if (Engine::IsKeyPressed(SDLK_RIGHT))
-            {
-                transform->RotateAroundAxis(glm::vec3(0, 1, 0), Engine::deltaTime);
-            }
-            if (Engine::IsKeyPressed(SDLK_q))
-            {
-                transform->RotateAroundAxis(glm::vec3(0, 0, -1), Engine::deltaTime);
-            }
-            if (Engine::IsKeyPressed(SDLK_e))
+            for (size_t i = 0; i < count; ++i)
             {
-                transform->RotateAroundAxis(glm::vec3(0, 0, 1), Engine::deltaTime);
+                const Manipulator* manipulator = &manipulators[i];
+                Transform* transform = &transforms[i];
+
+                // Movement controls
+                if (Engine::IsKeyPressed(SDLK_w)) { transform->position.z -= manipulator->moveSpeed * Engine::deltaTime; }
+                if (Engine::IsKeyPressed(SDLK_s)) { transform->position.z += manipulator->moveSpeed * Engine::deltaTime; }
+                if (Engine::IsKeyPressed(SDLK_a)) { transform->position.x -= manipulator->moveSpeed * Engine::deltaTime; }
+                if (Engine::IsKeyPressed(SDLK_d)) { transform->position.x += manipulator->moveSpeed * Engine::deltaTime; }
+                if (Engine::IsKeyPressed(SDLK_z)) { transform->position.y -= manipulator->moveSpeed * Engine::deltaTime; }
+                if (Engine::IsKeyPressed(SDLK_x)) { transform->position.y += manipulator->moveSpeed * Engine::deltaTime; }
+
+                // Rotation controls
+                if (Engine::IsKeyPressed(SDLK_UP))
+                {
+                    transform->RotateAroundAxis(glm::vec3(-1, 0, 0), Engine::deltaTime);
+                }
+                if (Engine::IsKeyPressed(SDLK_DOWN))
+                {
+                    transform->RotateAroundAxis(glm::vec3(1, 0, 0), Engine::deltaTime);
+                }
+                if (Engine::IsKeyPressed(SDLK_LEFT))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, -1, 0), Engine::deltaTime);
+                }
+                if (Engine::IsKeyPressed(SDLK_RIGHT))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, 1, 0), Engine::deltaTime);
+                }
+                if (Engine::IsKeyPressed(SDLK_q))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, 0, -1), Engine::deltaTime);
+                }
+                if (Engine::IsKeyPressed(SDLK_e))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, 0, 1), Engine::deltaTime);
+                }
             }
         }
-    );
-    Engine::AddSystem(manipulatorTransformSystem);
+    ));
 
     // int clickDetector = componentRegistry.getID<ClickDeletor>();
     // int aabbId = componentRegistry.getID<AABB>();
@@ -320,56 +321,60 @@ void GameClientImplementation::RegisterClientSystems()
     // Engine::AddSystem(mouseClick);
 
     // ---------------- NEW: Model Viewer System ----------------
-    int modelViewerTypeId = secs::ComponentRegistry::getID<ModelViewer>();
-    secs::System modelViewerSystem(
-        {modelViewerTypeId, transformTypeId},
-        [modelViewerTypeId, transformTypeId](secs::Entity e, secs::World& w)
+    Engine::AddSystem(secs::makeSystem<const ModelViewer, Transform>(
+        "ModelViewer",
+        [](const secs::Entity*, const ModelViewer* viewers, Transform* transforms, size_t count)
         {
-            auto* viewer    = w.getComponent<ModelViewer>(e);
-            auto* transform = w.getComponent<Transform>(e);
-
-            // Rotate around Y with Left/Right
-            if (Engine::IsKeyPressed(SDLK_LEFT))
-            {
-                transform->RotateAroundAxis(glm::vec3(0, 1, 0), Engine::deltaTime*100);
-            }
-            if (Engine::IsKeyPressed(SDLK_RIGHT))
-            {
-                transform->RotateAroundAxis(glm::vec3(0, -1, 0), Engine::deltaTime*100);
-            }
-            // Rotate around X with Up/Down
-            if (Engine::IsKeyPressed(SDLK_UP))
-            {
-                transform->RotateAroundAxis(glm::vec3(1, 0, 0), Engine::deltaTime*100);
-            }
-            if (Engine::IsKeyPressed(SDLK_DOWN))
+            for (size_t i = 0; i < count; ++i)
             {
-                transform->RotateAroundAxis(glm::vec3(-1, 0, 0), Engine::deltaTime*100);
-            }
+                const ModelViewer* viewer = &viewers[i];
+                Transform* transform = &transforms[i];
 
-            // Scale up/down with Numpad +/-
-            if (Engine::IsKeyPressed(SDLK_KP_PLUS))
-            {
-                // Uniform scale
-                transform->scale += glm::vec3(viewer->scaleSpeed) * Engine::deltaTime;
+                // Rotate around Y with Left/Right
+                if (Engine::IsKeyPressed(SDLK_LEFT))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, 1, 0), Engine::deltaTime*100);
+                }
+                if (Engine::IsKeyPressed(SDLK_RIGHT))
+                {
+                    transform->RotateAroundAxis(glm::vec3(0, -1, 0), Engine::deltaTime*100);
+                }
+                // Rotate around X with Up/Down
+                if (Engine::IsKeyPressed(SDLK_UP))
+                {
+                    transform->RotateAroundAxis(glm::vec3(1, 0, 0), Engine::deltaTime*100);
+                }
+                if (Engine::IsKeyPressed(SDLK_DOWN))
+                {
+                    transform->RotateAroundAxis(glm::vec3(-1, 0, 0), Engine::deltaTime*100);
+                }
+
+                // Scale up/down with Numpad +/-
+                if (Engine::IsKeyPressed(SDLK_KP_PLUS))
+                {
+                    // Uniform scale
+                    transform->scale += glm::vec3(viewer->scaleSpeed) * Engine::deltaTime;
+                }
+                if (Engine::IsKeyPressed(SDLK_KP_MINUS))
+                {
+                    transform->scale -= glm::vec3(viewer->scaleSpeed) * Engine::deltaTime;
+                    // OPTIONAL: clamp scale so we don’t go negative
+                    transform->scale = glm::max(transform->scale, glm::vec3(0.01f));
+                }
             }
-            if (Engine::IsKeyPressed(SDLK_KP_MINUS))
+        }
+    ));
+    
+    Engine::AddSystem(secs::makeSystem<const HelloWorldComponent, const Transform>(
+        "HelloWorld",
+        [](const secs::Entity*, const HelloWorldComponent*, const Transform*, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
             {
-                transform->scale -= glm::vec3(viewer->scaleSpeed) * Engine::deltaTime;
-                // OPTIONAL: clamp scale so we don’t go negative
-                transform->scale = glm::max(transform->scale, glm::vec3(0.01f));
+                std::cout << "hello world" << std::endl;
             }
         }
-    );
-    
-    Engine::AddSystem(modelViewerSystem);
-    int helloWorldCompId = secs::ComponentRegistry::getID<HelloWorldComponent>();
-    secs::System helloWorldSystem({helloWorldCompId, transformTypeId},
-                                  [helloWorldCompId, transformTypeId](secs::Entity e, secs::World& w)
-                                  {
-                                      std::cout << "hello world" << std::endl;
-                                  });
-    Engine::AddSystem(helloWorldSystem);
+    ));
 }
 
 
@@ -395,58 +400,107 @@ void GameClientImplementation::MoveCameraToViewAll()
     cameraTransform.UpdateModelMatrix();
 }
 */
-void RemoveLastPlaced(secs::World& w)
+void RemoveLastPlaced(secs::World& w, size_t count)
 {
-    auto lastMonkey = placedAssets.back();
-    w.destroyEntity(lastMonkey);
-    placedAssets.pop_back();
+    const size_t keep = placedAssets.size() - count;
+    w.destroyEntities(std::span<const secs::Entity>(placedAssets).subspan(keep));
+    placedAssets.resize(keep);
+    // Halving the scene frees whole blocks of chunks, hand them back
+    const size_t released = w.compact();
+    if (released > 0)
+    {
+        std::cout << "Released " << released / 1024 << " KB" << std::endl;
+    }
 }
 
 bool keepStuffInSight;
+// World bounds from the last time they were computed, and what they were computed from
+AABB sightBounds;
+bool sightBoundsValid = false;
+uint32_t sightBoundsTick = 0;
+size_t sightBoundsCount = 0;
 
 void GameClientImplementation::KeepStuffInSight()
 {
     if (!keepStuffInSight)
         return;
-    secs::queryChunks<Transform, AABB>(
-        world, // Pass the World instance as the first parameter
-        [&](const std::vector<secs::Entity>& ents,
-            const Transform* transforms,
-            const AABB* aabbs,
-            const size_t count)
+
+    // Only refresh the bounds if a transform or AABB was written (or something spawned/despawned) since last time
+    auto& boundsQuery = world.query<const Transform, const AABB>();
+    const size_t boundsCount = boundsQuery.count();
+    const bool stale = sightBoundsTick == 0 || boundsCount != sightBoundsCount
+        || boundsQuery.changedSince<Transform>(sightBoundsTick) || boundsQuery.changedSince<AABB>(sightBoundsTick);
+    if (stale)
+    {
+        RefreshSightBounds();
+        sightBoundsCount = boundsCount;
+        sightBoundsTick = world.advanceChangeTick();
+    }
+
+    if (!sightBoundsValid)
+    {
+        // No valid AABB found
+        return;
+    }
+
+    AABB worldAABB = sightBounds;
+    glm::vec3 pos;
+    glm::vec3 target;
+    worldAABB.AABBView(pos, target, glm::vec3(1.5, 4.5, 1), 5.5f);
+
+    Engine::camLook = target;
+    Engine::camPos = pos;
+}
+
+void GameClientImplementation::RefreshSightBounds()
+{
+    struct Bounds
+    {
+        bool valid = false;
+        AABB aabb{};
+
+        void Add(const glm::vec3& point)
+        {
+            if (!valid)
+            {
+                aabb = {point, point};
+                valid = true;
+            }
+            else
+            {
+                aabb.Encapsulate(point);
+            }
+        }
+    };
+
+    // Every thread bounds its own chunks, then the partial boxes get merged
+    const Bounds bounds = world.query<const Transform, const AABB>().reduceChunksParallel(
+        Bounds{},
+        [](Bounds& partial,
+           const secs::Entity*,
+           const Transform* transforms,
+           const AABB* aabbs,
+           const size_t count)
         {
 //            auto* cameraTransform = world.getComponent<Transform>(mainCamera);
-            bool first = true;
-            AABB worldAABB;
             for (size_t i = 0; i < count; ++i)
             {
                 auto entityAABB = aabbs[i];
                 auto entityTrans = transforms[i];
-                if (first)
-                {
-                    worldAABB = {entityTrans.Apply(entityAABB.min), entityTrans.Apply(entityAABB.max)};
-                    first = false;
-                }
-                else
-                {
-                    worldAABB.Encapsulate(entityTrans.Apply(entityAABB.min));
-                    worldAABB.Encapsulate(entityTrans.Apply(entityAABB.max));
-                }
+                partial.Add(entityTrans.Apply(entityAABB.min));
+                partial.Add(entityTrans.Apply(entityAABB.max));
             }
-
-            if (first)
-            {
-                // No valid AABB found
+        },
+        [](Bounds& total, const Bounds& partial)
+        {
+            if (!partial.valid)
                 return;
-            }
-
-            glm::vec3 pos;
-            glm::vec3 target;
-            worldAABB.AABBView(pos, target, glm::vec3(1.5, 4.5, 1), 5.5f);
-
-            Engine::camLook = target;
-            Engine::camPos = pos;
+            total.Add(partial.aabb.min);
+            total.Add(partial.aabb.max);
         });
+
+    sightBounds = bounds.aabb;
+    sightBoundsValid = bounds.valid;
 }
 
 
@@ -563,26 +617,41 @@ void GameClientImplementation::CycleModels()
     currentModelIndex++;
 }
 
-secs::Entity GameClientImplementation::PlacePrefab(std::string basic_string, Transform trans)
+const secs::Prefab& GameClientImplementation::GetPrefab(const std::string& name)
 {
-    bool found = false;
-    for (auto item : models)
+    auto cached = prefabs.find(name);
+    if (cached != prefabs.end())
+    {
+        return cached->second;
+    }
+    for (const auto& item : models)
     {
-        if (basic_string == item.name)
+        if (name == item.name)
         {
-            return secs::EntityBuilder(world)
-                .createEntity()
-                .set(trans)
-                .set(Shader{Engine::GetShader("basic")})
-                .set(Material{Engine::GetMaterial(item.textureFile)})
-                .set(Mesh{Engine::GetMesh(item.modelFile)})
-                .set(AABB{Engine::GetAABB(item.modelFile)})
-                .set(Name{item.name})
-                .build();
+            // Resources are looked up once here, placing copies the finished rows
+            secs::Prefab prefab = world.makePrefab(
+                Transform{},
+                Shader{Engine::GetShader("basic")},
+                Material{Engine::GetMaterial(item.textureFile)},
+                Mesh{Engine::GetMesh(item.modelFile)},
+                AABB{Engine::GetAABB(item.modelFile)},
+                Name{item.name});
+            return prefabs.emplace(name, std::move(prefab)).first->second;
         }
     }
-    std::cerr << "Prefab not found (" << basic_string << ")" << std::endl;
-    throw std::runtime_error("Prefab not found (" + basic_string + ")");;
+    std::cerr << "Prefab not found (" << name << ")" << std::endl;
+    throw std::runtime_error("Prefab not found (" + name + ")");
+}
+
+secs::Entity GameClientImplementation::PlacePrefab(std::string basic_string, Transform trans)
+{
+    return world.instantiate(GetPrefab(basic_string), std::span<const Transform>(&trans, 1)).front();
+}
+
+std::vector<secs::Entity> GameClientImplementation::PlacePrefabs(const std::string& name, const std::vector<Transform>& transforms)
+{
+    // Every row goes straight into the final archetype, only the transforms differ
+    return world.instantiate(GetPrefab(name), std::span<const Transform>(transforms));
 }
 
 
@@ -599,21 +668,28 @@ void GameClientImplementation::StartGame()
     auto pcTrans  = world.getComponent<Transform>(pcCar);
     pcTrans->UpdateModelMatrix();
     glm::vec2 offset {170, 75 };
-    
+
+    std::vector<Transform> grid;
     for (float i = -10.0; i < 10; ++i)
     {
         float rowOffset = static_cast<int>(i) % 2 == 0 ? offset.y * 0.5f : 0;
         for (float j = -10.0; j < 10; ++j)
         {
-            auto placed = PlacePrefab(rakennusKolme, Transform{glm::vec3(i * offset.x, 0, j * offset.y + rowOffset)});
-            auto buildingabb = world.getComponent<AABB>(placed);
-            auto buildingTrans = world.getComponent<Transform>(placed);
-            buildingTrans->UpdateModelMatrix();
-            if (PEPhysics::CheckAABBOverlap(*pcabb, *pcTrans, *buildingabb, *buildingTrans))
-            {
-                std::cout << "overlaps i" << i << "j" << j  << std::endl;
-             //   world.destroyEntity(placed);
-            }
+            grid.push_back(Transform{glm::vec3(i * offset.x, 0, j * offset.y + rowOffset)});
+        }
+    }
+
+    // The car lives in another archetype, so its pointers survive the bulk create
+    auto buildings = PlacePrefabs(rakennusKolme, grid);
+    for (auto placed : buildings)
+    {
+        auto buildingabb = world.getComponent<AABB>(placed);
+        auto buildingTrans = world.getComponent<Transform>(placed);
+        buildingTrans->UpdateModelMatrix();
+        if (PEPhysics::CheckAABBOverlap(*pcabb, *pcTrans, *buildingabb, *buildingTrans))
+        {
+            std::cout << "overlaps " << PositionString(buildingTrans->position) << std::endl;
+         //   world.destroyEntity(placed);
         }
     }
     //PlacePrefab(rakennusKolme, Transform{glm::vec3(-100,0,0)} );
@@ -648,12 +724,13 @@ void GameClientImplementation::OnUpdate(float deltaTime)
         const size_t placedCount = amount;
         const auto square = static_cast<size_t>(sqrt(placedCount));
 
-        for (int i = 0; i < square; ++i)
-        {
-            const auto asset = PlaceAsset(glm::vec3(0), "assets/models/monkey/mat.povertyMat",
-                                          "assets/models/monkey/monkey.fbx");
-            placedAssets.push_back(asset);
-        }
+        const auto monkeys = world.createEntities(square,
+            Transform{glm::vec3(0), glm::vec3(1.0f), glm::vec3(0.0f)},
+            Shader{Engine::GetShader("basic")},
+            Material{Engine::GetMaterial("assets/models/monkey/mat.povertyMat")},
+            Mesh{Engine::GetMesh("assets/models/monkey/monkey.fbx")},
+            AABB{Engine::GetAABB("assets/models/monkey/monkey.fbx")});
+        placedAssets.insert(placedAssets.end(), monkeys.begin(), monkeys.end());
         int size = placedAssets.size();
         for (int i = 0; i < size; ++i)
         {
@@ -673,15 +750,11 @@ void GameClientImplementation::OnUpdate(float deltaTime)
         {
             if (placedAssets.size() == 1)
             {
-                RemoveLastPlaced(world);
+                RemoveLastPlaced(world, 1);
             }
             else
             {
-                const int amount = static_cast<int>(placedAssets.size()) / 2;
-                for (int i = 0; i < amount; ++i)
-                {
-                    RemoveLastPlaced(world);
-                }
+                RemoveLastPlaced(world, placedAssets.size() / 2);
             }
 
 
@@ -694,18 +767,16 @@ void GameClientImplementation::OnUpdate(float deltaTime)
     }
     if (isGameOver)
     {
-        secs::queryChunks<Transform, AABB>(
+        secs::queryChunks<const Transform, const AABB>(
             world, // Pass the World instance as the first parameter
-            [&](const std::vector<secs::Entity>& ents,
+            [&](const secs::Entity*,
                 const Transform* transforms,
                 const AABB* aabbs,
                 const size_t count)
             {
                 for (size_t i = 0; i < count; ++i)
                 {
-                    auto* aabb = world.getComponent<AABB>(ents[i]);
-                    const auto* transform = world.getComponent<Transform>(ents[i]);
-                    aabb->DebugDraw(glm::vec3(1, 0, 0), *transform);
+                    aabbs[i].DebugDraw(glm::vec3(1, 0, 0), transforms[i]);
                 }
             });
       
@@ -715,19 +786,20 @@ void GameClientImplementation::OnUpdate(float deltaTime)
         StartGame();
     }
 
-    // if(Engine::GetMouseButtonUp(1))
-    // {
-    //     std::cout<<"Click" << std::endl;
-    //     glm::vec3 origin;
-    //     glm::vec3 dir;
-    //     PEPhysicsHitInfo hitInfo;
-    //     Engine::MousePositionToRay(origin, dir);
-    //     
-    //     if (PEPhysics::Raycast(origin, dir, world, hitInfo))
-    //     {
-    //         world.destroyEntity(hitInfo.entity);
-    //     }    
-    // }
+    if(Engine::GetMouseButtonUp(1))
+    {
+        std::cout<<"Click" << std::endl;
+        glm::vec3 origin;
+        glm::vec3 dir;
+        PEPhysicsHitInfo hitInfo;
+        Engine::MousePositionToRay(origin, dir);
+        
+        if (PEPhysics::Raycast(origin, dir, world, hitInfo))
+        {
+            // Deferred, the engine flushes after the systems have run
+            world.commands().destroyEntity(hitInfo.entity);
+        }    
+    }
 }
 
 void GameClientImplementation::OnShutdown()
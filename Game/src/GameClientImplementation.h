@@ -2,8 +2,10 @@
 #include "GameClient.h"
 #include "Engine.h"
 #include <iostream>
+#include <unordered_map>
 
 #include "ModelFileLoader.h"
+#include "SpatialIndex.h"
 
 class GameClientImplementation : public GameClient {
 public:
@@ -14,12 +16,15 @@ public:
 
     static void DrawCross(glm::vec3 pos);
     void KeepStuffInSight();
+    void RefreshSightBounds();
     static glm::vec3 GetCameraOffset();
 
     void PlayerControls();
     std::string LoadModels();
     void CycleModels();
+    const secs::Prefab& GetPrefab(const std::string& name);
     secs::Entity PlacePrefab(std::string basic_string, Transform trans);
+    std::vector<secs::Entity> PlacePrefabs(const std::string& name, const std::vector<Transform>& transforms);
     void StartGame();
     void OnUpdate(float deltaTime) override;
 
@@ -27,4 +32,6 @@ public:
     secs::Entity cameraLookPosEntity;
     secs::Entity groundEntity;
     std::vector<ModelData> models;
+    std::unordered_map<std::string, secs::Prefab> prefabs; // By model name, built on first use
+    std::unique_ptr<SpatialIndex> obstacles; // Everything with a Transform and an AABB, for the car's collisions
 };
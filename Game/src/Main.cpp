@@ -2,6 +2,7 @@
 #include "GameClientImplementation.h"
 #include "PEPhysicsTests.h"
 #include "Secs.h"
+#include "SecsTests.h"
 
 int main()
 {
@@ -9,6 +10,7 @@ int main()
 	/*
 #ifdef PE_DEBUG
 	PEPhysicsTests::RunAllTests();
+	SecsTests::RunAllTests();
 #endif
 */
 	Engine::Init(&client);
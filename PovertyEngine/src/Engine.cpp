@@ -11,6 +11,9 @@
 #include <Secs.h>
 #include <cstdlib>
 #include <utility>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
 
 #include "DebugLineRenderer.h"
 #include "EngineInfo.h"
@@ -18,6 +21,7 @@
 #include "ImGUIHelper.h"
 #include "MeshCache.h"
 #include "MaterialCache.h"
+#include "json.hpp"
 #include "systems/RenderSystem.h"
 
 GameClient*                           Engine::client;
@@ -38,6 +42,7 @@ std::unordered_map<int, bool>         Engine::heldMouseButtons;
 std::unordered_map<int, bool>         Engine::justPressedMouseButtons;
 std::unordered_map<int, bool>         Engine::justReleasedMouseButtons;
 std::unordered_map<std::string, std::string> Engine::debugDictionary;
+SystemScheduler                       Engine::scheduler;
 
 
 float Engine::deltaTime;
@@ -224,9 +229,10 @@ AABB Engine::GetAABB(const std::string& string)
     return  MeshCache::GetAABB(string);
 }
 
-void Engine::AddSystem(secs::System& system)
+void Engine::AddSystem(secs::System system)
 {
-    systems.push_back(system); 
+    systems.push_back(std::move(system));
+    scheduler.Invalidate();
 }
 bool Engine::GetKey(char key)
 {
@@ -325,6 +331,168 @@ float CalculateFPS(float& deltaTime) {
     return fps;
 }
 
+// One row per system: a bar from its start to its end inside the frame's system time, colored by thread.
+// Long bars sitting alone in their stage are the ones serializing the frame.
+void Engine::DrawScheduleTimeline()
+{
+    static const ImU32 threadColors[] = {
+        IM_COL32(230, 120, 60, 255), IM_COL32(80, 170, 230, 255), IM_COL32(120, 210, 90, 255),
+        IM_COL32(210, 90, 200, 255), IM_COL32(230, 210, 70, 255), IM_COL32(90, 220, 200, 255),
+    };
+    const auto& timeline = scheduler.GetTimeline();
+    const double frameMs = std::max(scheduler.GetFrameMs(), 0.001);
+    const float labelWidth = 220.0f;
+    const float barWidth = 300.0f;
+    const float rowHeight = ImGui::GetTextLineHeight();
+
+    ImGui::Separator();
+    ImGui::Text("systems: %.3f ms, %zu stages", scheduler.GetFrameMs(), scheduler.GetStageCount());
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    for (size_t i = 0; i < timeline.size() && i < systems.size(); ++i)
+    {
+        const auto& entry = timeline[i];
+        ImGui::Text("S%zu T%zu %s", entry.stage, entry.thread, systems[i].getName().c_str());
+        ImGui::SameLine(labelWidth);
+
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float x0 = origin.x + static_cast<float>(entry.startMs / frameMs) * barWidth;
+        const float x1 = origin.x + static_cast<float>(entry.endMs / frameMs) * barWidth;
+        drawList->AddRectFilled(origin, ImVec2(origin.x + barWidth, origin.y + rowHeight), IM_COL32(40, 40, 40, 255));
+        drawList->AddRectFilled(ImVec2(x0, origin.y), ImVec2(std::max(x1, x0 + 1.0f), origin.y + rowHeight),
+                                threadColors[entry.thread % std::size(threadColors)]);
+        ImGui::Dummy(ImVec2(barWidth, rowHeight));
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("%s: %.3f ms", systems[i].getName().c_str(), entry.endMs - entry.startMs);
+    }
+}
+
+// Where the entities live and what they cost. Hover a row for its columns.
+// Slack is allocated rows nobody lives in, moves are rows that came/left this frame through add/remove component.
+void Engine::DrawArchetypeStats()
+{
+    ImGui::Separator();
+    if (!ImGui::CollapsingHeader("archetypes"))
+        return;
+
+    const std::vector<secs::ArchetypeStats> stats = client->world.getArchetypeStats();
+    size_t totalBytes = 0;
+    for (const auto& arch : stats)
+        totalBytes += arch.allocatedBytes;
+    ImGui::Text("%zu archetypes, %zu entities, %.1f KB in chunks", stats.size(), client->world.getEntityCount(), totalBytes / 1024.0);
+    if (ImGui::Button("dump to ecs_stats.json"))
+        DumpEcsStats("ecs_stats.json");
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable;
+    if (!ImGui::BeginTable("archetypeStats", 6, flags, ImVec2(0.0f, 300.0f)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("components");
+    ImGui::TableSetupColumn("entities", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+    ImGui::TableSetupColumn("chunks");
+    ImGui::TableSetupColumn("slack");
+    ImGui::TableSetupColumn("KB");
+    ImGui::TableSetupColumn("moves in/out");
+    ImGui::TableHeadersRow();
+
+    std::vector<const secs::ArchetypeStats*> rows;
+    for (const auto& arch : stats)
+        rows.push_back(&arch);
+    if (const ImGuiTableSortSpecs* sort = ImGui::TableGetSortSpecs(); sort && sort->SpecsCount > 0)
+    {
+        const ImGuiTableColumnSortSpecs& spec = sort->Specs[0];
+        auto key = [&](const secs::ArchetypeStats* a) -> size_t {
+            switch (spec.ColumnIndex) {
+            case 2: return a->chunkCount;
+            case 3: return a->slackRows;
+            case 4: return a->allocatedBytes;
+            case 5: return a->movesIn + a->movesOut;
+            default: return a->entityCount;
+            }
+        };
+        std::stable_sort(rows.begin(), rows.end(), [&](const secs::ArchetypeStats* a, const secs::ArchetypeStats* b) {
+            if (spec.ColumnIndex == 0)
+                return spec.SortDirection == ImGuiSortDirection_Ascending ? a->signature < b->signature : a->signature > b->signature;
+            return spec.SortDirection == ImGuiSortDirection_Ascending ? key(a) < key(b) : key(a) > key(b);
+        });
+    }
+
+    for (const secs::ArchetypeStats* arch : rows)
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(arch->signature.c_str());
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::BeginTooltip();
+            for (const auto& column : arch->columns)
+                ImGui::Text("%s: %zu B each, %zu / %zu B used", column.name.c_str(), column.componentSize, column.usedBytes, column.allocatedBytes);
+            ImGui::EndTooltip();
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", arch->entityCount);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu x %zu", arch->chunkCount, arch->chunkCapacity);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", arch->slackRows);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", arch->allocatedBytes / 1024.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu / %zu", arch->movesIn, arch->movesOut);
+    }
+    ImGui::EndTable();
+}
+
+bool Engine::DumpEcsStats(const std::string& path)
+{
+    nlohmann::json report;
+    report["entities"] = client->world.getEntityCount();
+    report["archetypes"] = nlohmann::json::array();
+    for (const auto& arch : client->world.getArchetypeStats())
+    {
+        nlohmann::json columns = nlohmann::json::array();
+        for (const auto& column : arch.columns)
+        {
+            columns.push_back({
+                { "name", column.name },
+                { "componentSize", column.componentSize },
+                { "usedBytes", column.usedBytes },
+                { "allocatedBytes", column.allocatedBytes },
+            });
+        }
+        report["archetypes"].push_back({
+            { "signature", arch.signature },
+            { "entities", arch.entityCount },
+            { "chunks", arch.chunkCount },
+            { "chunkCapacity", arch.chunkCapacity },
+            { "slackRows", arch.slackRows },
+            { "allocatedBytes", arch.allocatedBytes },
+            { "movesIn", arch.movesIn },
+            { "movesOut", arch.movesOut },
+            { "columns", columns },
+        });
+    }
+    report["sparseSets"] = nlohmann::json::array();
+    for (const auto& set : client->world.getSparseSetStats())
+    {
+        report["sparseSets"].push_back({
+            { "name", set.name },
+            { "entities", set.entityCount },
+            { "usedBytes", set.usedBytes },
+        });
+    }
+
+    std::ofstream file(path);
+    file << report.dump(2) << std::endl;
+    if (!file)
+    {
+        std::cerr << "Couldn't write ECS stats to " << path << std::endl;
+        return false;
+    }
+    std::cout << "ECS stats written to " << path << std::endl;
+    return true;
+}
+
 void Engine::MainLoop()
 {
     static Uint32 lastTime = SDL_GetTicks();
@@ -334,6 +502,7 @@ void Engine::MainLoop()
     time += deltaTime;
 
     ProcessEvents();
+    client->world.resetFrameStats();
     
     glClearColor(0.0f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -347,8 +516,9 @@ void Engine::MainLoop()
     */
     client->OnUpdate(deltaTime);
 
-    for (auto system : systems)
-        system.execute(client->world);
+    scheduler.Run(systems, client->world);
+    // Sync point: structural changes recorded by OnUpdate and the systems land here
+    client->world.flushCommands();
 
     viewMatrix = glm::lookAt(camPos, camLook, camUp);
 
@@ -362,6 +532,8 @@ void Engine::MainLoop()
     
 
     const int renderedCount = RenderSystem::Render(client->world);
+    // Model matrices are final now: hooks and indices hear about this frame's writes
+    client->world.publishChanges();
     debugLineRenderer->Render(viewMatrix, projectionMatrix, debugLineShader);
 
     debugDictionary["deltaTime"] = std::to_string(deltaTime),
@@ -378,6 +550,8 @@ void Engine::MainLoop()
         oss << element.first << ": " << element.second << "\n";
     }
     ImGui::Text("%s", oss.str().c_str());
+    DrawScheduleTimeline();
+    DrawArchetypeStats();
     ImGui::End();
     GLenum error = glGetError();
     if (error != GL_NO_ERROR)
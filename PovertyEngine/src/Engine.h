@@ -7,6 +7,7 @@
 #include "GameClient.h"
 #include "MaterialCache.h"
 #include "PEPhysics.h"
+#include "SystemScheduler.h"
 #include "systems/RenderSystem.h"
 
 class PE_API Engine
@@ -30,13 +31,15 @@ public:
 	static Material GetMaterial(const std::string& materialFilePath);
 	static Mesh GetMesh(const std::string& string);
 	static AABB GetAABB(const std::string& string);
-	static void AddSystem(secs::System& createSystem);
+	static void AddSystem(secs::System system);
 	static bool GetKey(char key);
 	static bool GetKeyUp(char key);
 
 	static void DisplayMessage(const char* message);
 	static void DebugDrawLine(const glm::vec3& start, const glm::vec3& end, const glm::vec3& color, float lineWidth);
 	static void DebugStat(const std::string& key, std::string val);
+	// Write the archetype/sparse set stats of the client world as JSON
+	static bool DumpEcsStats(const std::string& path);
 
 	static GameClient* client;
 	static char* baseFilePath;
@@ -65,5 +68,9 @@ private:
 	
 	static std::unordered_map<std::string, std::string> debugDictionary;
 
+	static SystemScheduler scheduler;
+	static void DrawScheduleTimeline();
+	static void DrawArchetypeStats();
+
 	
 };
@@ -0,0 +1,170 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+thread_local size_t JobSystem::threadIndex = 0;
+thread_local bool JobSystem::insideJob = false;
+
+JobSystem::JobSystem(size_t workerThreads)
+{
+    if (workerThreads == 0)
+    {
+        const size_t hardwareThreads = std::thread::hardware_concurrency();
+        workerThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    ranges = std::make_unique<WorkRange[]>(workerThreads + 1);
+    workers.reserve(workerThreads);
+    for (size_t i = 0; i < workerThreads; ++i)
+    {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        shuttingDown = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::Get()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+void JobSystem::Run(size_t count, void* ctx, InvokeFn invoke)
+{
+    if (count == 0)
+        return;
+
+    // Nested call, no workers, or somebody else is using the pool: just do it here
+    if (insideJob || workers.empty() || !runMutex.try_lock())
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            invoke(ctx, i, threadIndex);
+        }
+        return;
+    }
+
+    const size_t threadCount = GetThreadCount();
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        const auto begin = static_cast<uint32_t>(count * i / threadCount);
+        const auto end = static_cast<uint32_t>(count * (i + 1) / threadCount);
+        ranges[i].range.store(Pack(begin, end), std::memory_order_relaxed);
+    }
+    jobContext = ctx;
+    jobInvoke = invoke;
+    remaining.store(count, std::memory_order_relaxed);
+    activeWorkers.store(workers.size(), std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        ++jobGeneration;
+    }
+    wakeCondition.notify_all();
+
+    // The calling thread works too
+    const size_t previousIndex = threadIndex;
+    threadIndex = 0;
+    insideJob = true;
+    Drain(0);
+
+    // Wait for stragglers, every worker has to check out before the job state can be reused
+    while (remaining.load(std::memory_order_acquire) != 0 || activeWorkers.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+    insideJob = false;
+    threadIndex = previousIndex;
+    runMutex.unlock();
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+    threadIndex = index;
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&] { return shuttingDown || jobGeneration != seenGeneration; });
+            if (shuttingDown)
+                return;
+            seenGeneration = jobGeneration;
+        }
+
+        insideJob = true;
+        Drain(index);
+        insideJob = false;
+        activeWorkers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void JobSystem::Drain(size_t self)
+{
+    do
+    {
+        size_t index;
+        while (PopFront(self, index))
+        {
+            jobInvoke(jobContext, index, self);
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+    while (Steal(self));
+}
+
+bool JobSystem::PopFront(size_t slot, size_t& index)
+{
+    auto& range = ranges[slot].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    while (true)
+    {
+        const uint32_t begin = Begin(current);
+        const uint32_t end = End(current);
+        if (begin >= end)
+            return false;
+        if (range.compare_exchange_weak(current, Pack(begin + 1, end), std::memory_order_acq_rel))
+        {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+bool JobSystem::Steal(size_t thief)
+{
+    const size_t threadCount = GetThreadCount();
+    for (size_t offset = 1; offset < threadCount; ++offset)
+    {
+        auto& range = ranges[(thief + offset) % threadCount].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (true)
+        {
+            const uint32_t begin = Begin(current);
+            const uint32_t end = End(current);
+            if (begin >= end)
+                break;
+
+            // Take the back half (rounded up, so a single leftover item can be stolen too)
+            const uint32_t split = end - (end - begin + 1) / 2;
+            if (range.compare_exchange_weak(current, Pack(begin, split), std::memory_order_acq_rel))
+            {
+                // Our own slot is empty, so publishing the stolen part lets others steal from it in turn
+                ranges[thief].range.store(Pack(split, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
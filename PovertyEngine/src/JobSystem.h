@@ -0,0 +1,88 @@
+#pragma once
+#include "Core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    ===================
+    JOB SYSTEM
+    ===================
+    - A fixed pool of worker threads plus the calling thread.
+    - parallelFor splits [0, count) into one contiguous range per thread.
+      Each thread eats its own range from the front, and once it runs dry it
+      steals the back half of someone else's range. Ranges are packed into one
+      atomic word and only ever shrunk with CAS, so every index runs exactly once.
+    - Nested calls, or calls while another thread owns the pool, just run serially.
+*/
+class PE_API JobSystem
+{
+public:
+    // workerThreads == 0 means "hardware threads - 1"
+    explicit JobSystem(size_t workerThreads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Engine-wide pool, created on first use
+    static JobSystem& Get();
+
+    // Threads that can take part in a parallelFor, including the caller
+    size_t GetThreadCount() const { return workers.size() + 1; }
+
+    // Index of the calling thread inside the current parallelFor: 0 for the caller, 1.. for workers
+    static size_t GetThreadIndex() { return threadIndex; }
+
+    // Calls task(index, threadIndex) for every index in [0, count). Returns once all of them finished.
+    template<typename Task>
+    void ParallelFor(size_t count, Task&& task)
+    {
+        using TaskType = std::remove_reference_t<Task>;
+        Run(count, &task, [](void* ctx, size_t index, size_t thread)
+        {
+            (*static_cast<TaskType*>(ctx))(index, thread);
+        });
+    }
+
+private:
+    using InvokeFn = void(*)(void* ctx, size_t index, size_t thread);
+
+    // [begin, end) packed as (begin << 32) | end
+    struct alignas(64) WorkRange {
+        std::atomic<uint64_t> range{0};
+    };
+
+    void Run(size_t count, void* ctx, InvokeFn invoke);
+    void WorkerLoop(size_t index);
+    void Drain(size_t self);
+    bool PopFront(size_t slot, size_t& index);
+    bool Steal(size_t thief);
+
+    static uint64_t Pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(begin) << 32) | end; }
+    static uint32_t Begin(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+    static uint32_t End(uint64_t range) { return static_cast<uint32_t>(range); }
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<WorkRange[]> ranges; // One per thread, slot 0 is the caller
+
+    // Current job
+    void* jobContext = nullptr;
+    InvokeFn jobInvoke = nullptr;
+    std::atomic<size_t> remaining{0};
+    std::atomic<size_t> activeWorkers{0};
+
+    std::mutex runMutex;   // Held by whoever owns the pool for a parallelFor
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    uint64_t jobGeneration = 0;
+    bool shuttingDown = false;
+
+    static thread_local size_t threadIndex;
+    static thread_local bool insideJob;
+};
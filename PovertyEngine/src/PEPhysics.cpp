@@ -43,7 +43,7 @@ void AABB::Encapsulate(glm::vec3 vec)
     max.z = std::max(max.z, vec.z);
 }
 
-void AABB::DebugDraw(glm::vec3 color, const Transform& transform)
+void AABB::DebugDraw(glm::vec3 color, const Transform& transform) const
 {
     // Calculate the transformed AABB corners
     glm::vec3 corners[8] = {
@@ -122,7 +122,7 @@ bool PEPhysics::RaycastAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDire
     return true;
 }
 
-static AABB TransformAABBToWorld(const AABB& aabb, const Transform& transform)
+AABB PEPhysics::TransformAABBToWorld(const AABB& aabb, const Transform& transform)
 {
     glm::vec3 worldMin(std::numeric_limits<float>::max());
     glm::vec3 worldMax(std::numeric_limits<float>::lowest());
@@ -165,32 +165,50 @@ bool PEPhysics::CheckAABBOverlap(const AABB& aabb1, const Transform& transform1,
 
 bool PEPhysics::Raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, secs::World& world, PEPhysicsHitInfo& hitInfo)
 {
-    bool isHit = false;
-    float minDist = std::numeric_limits<float>::max();
-    secs::queryChunks<Transform, AABB>(world, [&](
-        const std::vector<secs::Entity>& ents,
-        const Transform* transform,
-        const AABB* aabb,
-        const size_t count
-        )
+    struct ClosestHit
     {
-        for (size_t i = 0; i < count; ++i)
+        bool isHit = false;
+        PEPhysicsHitInfo info{};
+    };
+
+    // Every thread keeps its own closest hit, then the closest of those wins
+    const ClosestHit closest = world.query<const Transform, const AABB>().reduceChunksParallel(
+        ClosestHit{},
+        [&](ClosestHit& best,
+            const secs::Entity* ents,
+            const Transform* transform,
+            const AABB* aabb,
+            const size_t count)
         {
-            float dist;
-            glm::vec3 point;
-            const bool currentHit = RaycastAABB(rayOrigin, rayDirection, aabb[i], transform[i], dist, point);
-            if (currentHit && dist < minDist)
+            for (size_t i = 0; i < count; ++i)
             {
-                minDist = dist;
-                hitInfo.point = point;
-                hitInfo.distance = dist;
-                hitInfo.entity = ents[i];
-                isHit = true;
+                float dist;
+                glm::vec3 point;
+                const bool currentHit = RaycastAABB(rayOrigin, rayDirection, aabb[i], transform[i], dist, point);
+                if (currentHit && (!best.isHit || dist < best.info.distance))
+                {
+                    best.info.point = point;
+                    best.info.distance = dist;
+                    best.info.entity = ents[i];
+                    best.isHit = true;
+                }
             }
-        }
-    });
-  
-    return isHit;
+        },
+        [](ClosestHit& total, const ClosestHit& partial)
+        {
+            if (!partial.isHit)
+                return;
+            // Tie-break on the entity id so the result doesn't depend on how chunks got split
+            if (!total.isHit || partial.info.distance < total.info.distance ||
+                (partial.info.distance == total.info.distance && partial.info.entity.id < total.info.entity.id))
+            {
+                total = partial;
+            }
+        });
+
+    if (closest.isHit)
+        hitInfo = closest.info;
+    return closest.isHit;
     
 }
 
@@ -14,7 +14,7 @@ struct PE_API AABB
 
     void Encapsulate(glm::vec3 vec);
     
-    void DebugDraw(glm::vec3 color, const Transform& transform);
+    void DebugDraw(glm::vec3 color, const Transform& transform) const;
 };
 
 struct PEPhysicsHitInfo
@@ -31,6 +31,8 @@ public:
     static bool RaycastAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
                             const AABB& aabb, const Transform& transform, float& tMin,
                             glm::vec3& intersectionPoint);
+    // Box around aabb once transform's model matrix is applied
+    static AABB TransformAABBToWorld(const AABB& aabb, const Transform& transform);
     static bool CheckAABBOverlap(const AABB& aabb1, const Transform& transform1,
                                  const AABB& aabb2, const Transform& transform2);
     static bool Raycast(
@@ -1,11 +1,14 @@
 #include "PEPhysicsTests.h"
 
+#include <algorithm>
+
 #include <vector>
 #include <glm.hpp>
 #include <iostream>
 #include <ostream>
 #include <PEPhysics.h>
 #include "systems/TransformSystem.h"
+#include "SpatialIndex.h"
 
 void PEPhysicsTests::TestEmptyMesh() {
     try {
@@ -68,6 +71,50 @@ void PEPhysicsTests::TestMultiplePointsMesh() {
     
 }
 
+void PEPhysicsTests::TestSpatialIndex() {
+    secs::ComponentRegistry::registerType<Transform>("Transform");
+    secs::ComponentRegistry::registerType<AABB>("AABB");
+    secs::World world;
+    const AABB unit = {{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}};
+    auto placed = [](float x, float z) {
+        Transform transform{glm::vec3(x, 0.0f, z)};
+        transform.UpdateModelMatrix();
+        return transform;
+    };
+
+    // One entity already there, the rest come in through the hooks
+    secs::Entity near = world.createEntities(1, placed(0.0f, 0.0f), unit).front();
+    SpatialIndex index(world, 8.0f);
+    secs::Entity far = world.createEntities(1, placed(100.0f, 100.0f), unit).front();
+    secs::Entity ground = world.createEntities(1, placed(0.0f, 0.0f), AABB{{-500.0f, -1.0f, -500.0f}, {500.0f, 0.0f, 500.0f}}).front();
+    world.createEntity({secs::ComponentRegistry::getID<Transform>()}); // No AABB, not indexed
+
+    std::vector<secs::Entity> found;
+    index.Query({{-2.0f, -2.0f, -2.0f}, {2.0f, 2.0f, 2.0f}}, found);
+    bool ok = index.GetCount() == 3 && found.size() == 2
+        && std::find(found.begin(), found.end(), near) != found.end()
+        && std::find(found.begin(), found.end(), ground) != found.end();
+
+    // Moves land when the world publishes its changes
+    *world.getComponent<Transform>(far) = placed(1.0f, 1.0f);
+    world.publishChanges();
+    found.clear();
+    index.Query({{-2.0f, -2.0f, -2.0f}, {2.0f, 2.0f, 2.0f}}, found);
+    ok &= found.size() == 3;
+
+    world.removeComponent<AABB>(near);
+    world.destroyEntity(ground);
+    found.clear();
+    index.Query({{-2.0f, -2.0f, -2.0f}, {2.0f, 2.0f, 2.0f}}, found);
+    ok &= index.GetCount() == 1 && found.size() == 1 && found.front() == far;
+
+    if (ok) {
+        std::cout << "TestSpatialIndex passed.\n";
+    } else {
+        std::cerr << "TestSpatialIndex failed.\n";
+    }
+}
+
 void PEPhysicsTests::RunAllTests()
 {
     std::cout << "==== PEPhysics tests ====" << std::endl;
@@ -75,5 +122,6 @@ void PEPhysicsTests::RunAllTests()
     TestSinglePointMesh();
     TestMultiplePointsMesh();
     TestRaycastAABB();
+    TestSpatialIndex();
     std::cout << "==========================" << std::endl;
 }
@@ -12,5 +12,6 @@ private:
     static void TestSinglePointMesh();
     static void TestMultiplePointsMesh();
     static void TestRaycastAABB();
+    static void TestSpatialIndex();
 };
 
@@ -1,18 +1,29 @@
 #pragma once
 
 #include "core.h"  // Where you define PE_BUILD_DLL and PE_API
+#include "JobSystem.h"
 
 #include <iostream>
 #include <unordered_map>
 #include <map>
 #include <string>
 #include <vector>
-#include <typeindex>
 #include <algorithm>
 #include <memory>
 #include <cassert>
 #include <functional>
 #include <cstring>
+#include <bitset>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <span>
+#include <optional>
+#include <tuple>
+#include <utility>
 
 /*
     =================================================
@@ -22,519 +33,3742 @@
 namespace secs
 {
 
+// Upper bound on registered component types. Archetype signatures are a bitmask this wide.
+constexpr int MAX_COMPONENTS = 64;
+
+// One bit per component ID
+using Signature = std::bitset<MAX_COMPONENTS>;
+
+// Upper bound on distinct Query<...> types in the program, each gets a slot in every World's query cache
+constexpr size_t MAX_QUERY_TYPES = 512;
+
+/*
+    ===================
+    COMPONENT OPS
+    ===================
+    Type-erased lifecycle for a component, so storage can construct, move and destroy
+    values it only knows by ID. Every function works on count consecutive values.
+    Types that are trivially copyable are flagged, and storage memcpys those instead
+    of going through the function pointers.
+*/
+struct PE_API ComponentOps {
+    void (*construct)(void* dst, size_t count) = nullptr;           // Value-initialize
+    void (*relocate)(void* dst, void* src, size_t count) = nullptr; // Move-construct into dst, then destroy src
+    void (*destroy)(void* ptr, size_t count) = nullptr;
+    void (*copy)(void* dst, const void* src, size_t count) = nullptr;   // Copy-construct dst[i] from src[i], nullptr if T can't be copied
+    void (*fill)(void* dst, const void* value, size_t count) = nullptr; // Copy-construct every dst[i] from *value, same
+    bool trivialConstruct = true; // Value-init is all zero bytes
+    bool trivialRelocate  = true; // memcpy moves it and there's nothing to destroy
+};
+
+template<typename T>
+ComponentOps makeComponentOps()
+{
+    static_assert(std::is_default_constructible_v<T>, "Components need a default constructor");
+    static_assert(std::is_move_constructible_v<T>, "Components need to be movable");
+
+    ComponentOps ops;
+    ops.construct = [](void* dst, size_t count) {
+        std::uninitialized_value_construct_n(static_cast<T*>(dst), count);
+    };
+    ops.relocate = [](void* dst, void* src, size_t count) {
+        T* from = static_cast<T*>(src);
+        std::uninitialized_move_n(from, count, static_cast<T*>(dst));
+        std::destroy_n(from, count);
+    };
+    ops.destroy = [](void* ptr, size_t count) {
+        std::destroy_n(static_cast<T*>(ptr), count);
+    };
+    if constexpr (std::is_copy_constructible_v<T>) {
+        ops.copy = [](void* dst, const void* src, size_t count) {
+            std::uninitialized_copy_n(static_cast<const T*>(src), count, static_cast<T*>(dst));
+        };
+        ops.fill = [](void* dst, const void* value, size_t count) {
+            std::uninitialized_fill_n(static_cast<T*>(dst), count, *static_cast<const T*>(value));
+        };
+    }
+    ops.trivialConstruct = std::is_trivially_default_constructible_v<T>;
+    ops.trivialRelocate  = std::is_trivially_copyable_v<T>;
+    return ops;
+}
+
+// Where a component type lives.
+// Table components are archetype columns: fastest to iterate, but adding or removing one moves the row.
+// Sparse components live in a SparseSet next to the archetypes: toggling them is O(1) and moves nothing,
+// at the cost of a lookup per entity when a query includes them. Meant for tags that come and go.
+// Shared components are stored once per archetype instead of once per row: entities with equal values
+// (compared bytewise) share an archetype, and so every chunk of it. Meant for render state like meshes
+// that thousands of entities have in common. Changing the value moves the row; only trivially copyable
+// types can be shared, and queries read them through Shared<T>.
+enum class StorageKind : uint8_t { Table, Sparse, Shared };
+
+// Opt-in reflection for a field-split table column. Specialize it with T's members, in the order
+// their arrays go in the column:
+//     template<> struct secs::SplitFields<Velocity> {
+//         static constexpr auto members = std::make_tuple(&Velocity::x, &Velocity::y, &Velocity::z);
+//     };
+// and a chunk stores x[capacity] y[capacity] z[capacity] instead of capacity whole Velocitys, so a
+// SIMD loop over one field reads consecutive floats. The members have to cover every byte of T
+// (no padding) and T has to be trivially copyable. Queries hand the arrays out through Split<T>.
+template<typename T>
+struct SplitFields {};
+
+// Most fields a split component can have
+constexpr size_t MAX_FIELDS = 16;
+
+// One field of a split component
+struct PE_API FieldInfo {
+    size_t offset = 0; // Inside T
+    size_t size   = 0;
+    size_t start  = 0; // Sizes of the fields before it: its array starts start * capacity bytes into the column
+};
+
+namespace detail
+{
+    // ID of component type T, -1 until it's registered. One variable per type, so looking an ID
+    // up is a load from a fixed address instead of hashing a std::type_index
+    template<typename T>
+    inline int componentID = -1;
+
+    template<typename T>
+    concept HasSplitFields = requires { SplitFields<T>::members; };
+
+    // Default-constructed T that new rows of a split column are filled from
+    template<typename T>
+    inline const T splitDefault{};
+}
+
+// What's known about one registered component
+struct PE_API ComponentInfo {
+    size_t size      = 0;
+    size_t alignment = 0;
+    std::string name;
+    ComponentOps ops;
+    StorageKind storage = StorageKind::Table;
+    // Field-split column layout (see SplitFields), fieldCount is 0 for whole structs
+    std::array<FieldInfo, MAX_FIELDS> fields{};
+    size_t fieldCount = 0;
+    const uint8_t* defaultValue = nullptr; // detail::splitDefault<T>, split types only
+};
+
 /*
     ===================
     COMPONENT REGISTRY
     ===================
-    - Keeps a mapping from C++ type to a unique integer ID.
-    - Stores the size of each component type for chunk/SoA allocations.
+    - Gives each C++ type a unique integer ID, kept in a per-type variable (detail::componentID).
+    - Stores the size and alignment of each component type for chunk/SoA allocations.
+    - Stores the lifecycle ops, so non-trivial types (std::string and friends) are moved for real.
+    - Stores the storage kind. Empty types are registered with size 0 and take no column bytes.
+    - Stores the field layout of types that opted into field-split columns (SplitFields).
+    - Everything per ID sits in one flat array indexed by ID.
     - ECS code uses only integer IDs to identify components.
 */
 class PE_API ComponentRegistry {
 public:
+    using Info = ComponentInfo;
+
     // Register a new component type T with an internal integer ID.
     template<typename T>
-    static int registerType(const std::string& name) {
-        std::type_index tIndex(typeid(T));
+    static int registerType(const std::string& name, StorageKind storage = StorageKind::Table) {
+        int& id = detail::componentID<std::remove_cv_t<T>>;
         // If already registered, just return the existing ID
-        if (typeToID.find(tIndex) != typeToID.end()) {
-            return typeToID[tIndex];
+        if (id >= 0) {
+            return id;
         }
         // Otherwise, assign a new ID
+        if (nextID >= MAX_COMPONENTS) {
+            throw std::runtime_error("Too many component types, raise secs::MAX_COMPONENTS!");
+        }
+        if (storage == StorageKind::Shared && !std::is_trivially_copyable_v<T>) {
+            throw std::runtime_error("Shared components have to be trivially copyable: " + name);
+        }
+        Info info;
+        info.size      = std::is_empty_v<T> ? 0 : sizeof(T);
+        info.alignment = alignof(T);
+        info.name      = name;
+        info.ops       = makeComponentOps<T>();
+        info.storage   = storage;
+        if constexpr (detail::HasSplitFields<T>) {
+            describeFields<T>(info);
+        }
         int newID = nextID++;
         std::cout << "Registered type:: " << newID << " name: " << name << std::endl;
-        typeToID[tIndex] = newID;
-        idToSize[newID]   = sizeof(T);
-        idToName[newID]   = name;
+        infos[newID] = std::move(info);
+        id = newID;
         return newID;
     }
 
     // Retrieve the unique ID for a component T
     template<typename T>
     static int getID() {
-        std::type_index tIndex(typeid(T));
-        auto it = typeToID.find(tIndex);
-        if (it == typeToID.end()) {
+        const int id = detail::componentID<std::remove_cv_t<T>>;
+        if (id < 0) [[unlikely]] {
             throw std::runtime_error("Type not registered with ComponentRegistry!");
         }
-        return it->second;
+        return id;
+    }
+
+    // Everything known about compID
+    static const Info& getInfo(int compID) {
+        if (!isRegistered(compID)) {
+            throw std::runtime_error("getInfo called on unknown component ID!");
+        }
+        return infos[compID];
     }
 
     // Get the size of a component by its ID
     static size_t getSize(int compID) {
-        auto it = idToSize.find(compID);
-        if (it == idToSize.end()) {
+        if (!isRegistered(compID)) {
             throw std::runtime_error("getSize called on unknown component ID!");
         }
-        return it->second;
+        return infos[compID].size;
+    }
+
+    static size_t getAlignment(int compID) {
+        if (!isRegistered(compID)) {
+            throw std::runtime_error("getAlignment called on unknown component ID!");
+        }
+        return infos[compID].alignment;
+    }
+
+    // Get the lifecycle ops of a component by its ID
+    static const ComponentOps& getOps(int compID) {
+        if (!isRegistered(compID)) {
+            throw std::runtime_error("getOps called on unknown component ID!");
+        }
+        return infos[compID].ops;
+    }
+
+    static StorageKind getStorage(int compID) {
+        return isRegistered(compID) ? infos[compID].storage : StorageKind::Table;
+    }
+
+    static bool isSparse(int compID) {
+        return getStorage(compID) == StorageKind::Sparse;
+    }
+
+    static bool isShared(int compID) {
+        return getStorage(compID) == StorageKind::Shared;
+    }
+
+    // Table component stored as one array per field, see SplitFields
+    static bool isSplit(int compID) {
+        return isRegistered(compID) && infos[compID].fieldCount > 0;
+    }
+
+    // ID registered under name, -1 if there's none. Saved data refers to components by name
+    static int findID(const std::string& name) {
+        for (int id = 0; id < nextID; ++id) {
+            if (infos[id].name == name) return id;
+        }
+        return -1;
     }
 
     // (Optional) name retrieval for debugging
     static const std::string& getName(int compID) {
-        auto it = idToName.find(compID);
-        if (it == idToName.end()) {
+        if (!isRegistered(compID)) {
             static std::string unknown = "UnknownComponent";
             return unknown;
         }
-        return it->second;
+        return infos[compID].name;
+    }
+
+    static bool isRegistered(int compID) {
+        return compID >= 0 && compID < nextID;
     }
 
+    // Number of registered types, IDs are 0..getCount()-1
+    static int getCount() { return nextID; }
+
 private:
+    // Field layout from SplitFields<T>, checked so every array starts aligned whatever the chunk capacity
+    template<typename T>
+    static void describeFields(Info& info)
+    {
+        using Members = decltype(SplitFields<T>::members);
+        static_assert(std::tuple_size_v<Members> <= MAX_FIELDS, "Too many split fields, raise secs::MAX_FIELDS!");
+        if (info.storage != StorageKind::Table || !std::is_trivially_copyable_v<T>) {
+            throw std::runtime_error("Split components have to be trivially copyable table components: " + info.name);
+        }
+        const T& probe = detail::splitDefault<T>;
+        const auto* base = reinterpret_cast<const uint8_t*>(&probe);
+        std::apply([&](auto... members) {
+            ([&] {
+                using Field = std::remove_cvref_t<decltype(probe.*members)>;
+                FieldInfo& field = info.fields[info.fieldCount];
+                field.offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(&(probe.*members)) - base);
+                field.size   = sizeof(Field);
+                field.start  = info.fieldCount == 0 ? 0 : info.fields[info.fieldCount - 1].start + info.fields[info.fieldCount - 1].size;
+                if (field.start % alignof(Field) != 0) {
+                    throw std::runtime_error("Split fields of " + info.name + " have to go in order of alignment, largest first!");
+                }
+                ++info.fieldCount;
+            }(), ...);
+        }, SplitFields<T>::members);
+
+        // Exactly T's bytes: no gaps and no field twice
+        std::array<FieldInfo, MAX_FIELDS> byOffset = info.fields;
+        std::sort(byOffset.begin(), byOffset.begin() + info.fieldCount, [](const FieldInfo& a, const FieldInfo& b) { return a.offset < b.offset; });
+        size_t covered = 0;
+        for (size_t f = 0; f < info.fieldCount; ++f) {
+            if (byOffset[f].offset != covered) {
+                throw std::runtime_error("Split fields of " + info.name + " have to cover every byte of it exactly once!");
+            }
+            covered += byOffset[f].size;
+        }
+        if (covered != sizeof(T)) {
+            throw std::runtime_error("Split fields of " + info.name + " have to cover every byte of it exactly once!");
+        }
+        info.defaultValue = base;
+    }
+
     // Next available integer for a new component type
     static inline int nextID = 0;
 
-    // Maps from a std::type_index -> assigned ID
-    static inline std::unordered_map<std::type_index, int> typeToID;
-    // Maps from ID -> size
-    static inline std::unordered_map<int, size_t> idToSize;
-    // Maps from ID -> a friendly name (for debugging)
-    static inline std::unordered_map<int, std::string> idToName;
+    // Indexed by ID
+    static inline std::array<Info, MAX_COMPONENTS> infos;
 };
 
 /*
     ===================
     ENTITY
     ===================
-    Just an ID. Add a version if you want.
+    A slot index plus a generation. The slot gets recycled after the entity is
+    destroyed and the generation bumped, so stale handles stop resolving.
 */
 struct PE_API Entity {
-    uint32_t id;
+    uint32_t id         = 0; // Slot in World's entity table
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const { return id == other.id && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// Where an entity's row lives inside its archetype
+struct PE_API EntityLocation {
+    uint32_t chunk = 0;
+    uint32_t row   = 0;
 };
 
 /*
     ===================
     SIGNATURE BUILDING
     ===================
-    We create a canonical string from a list of component IDs
-    so we can identify & cache Archetypes in a map.
+    We set one bit per component ID so we can identify & cache Archetypes in a map.
+    Ordering of the input doesn't matter.
 */
-inline PE_API std::string buildSignature(const std::vector<int>& compIDs)
+inline PE_API Signature buildSignature(const std::vector<int>& compIDs)
 {
-    // Sort them for stable ordering
-    std::vector<int> sorted = compIDs;
-    std::sort(sorted.begin(), sorted.end());
-
-    // Build a string like "1;5;7;" for an archetype that has compIDs = {1,5,7}
-    std::string sig;
-    for (auto id : sorted) {
-        sig += std::to_string(id) + ";";
+    Signature sig;
+    for (auto id : compIDs) {
+        sig.set(id);
     }
     return sig;
 }
 
+// Bytes per archetype chunk
+constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+// Column start alignment inside a chunk. A cache line, so columns never share one and aligned AVX loads work
+constexpr size_t COLUMN_ALIGNMENT = 64;
+
 /*
     ===================
-    ARCHETYPE
+    CHUNK ALLOCATOR
     ===================
-    Groups entities that have the same set of components (same signature).
-    Stores data in a SoA layout for each component ID.
+    Where archetype chunks get their memory. Every block handed out is COLUMN_ALIGNMENT aligned.
+    Pluggable, so several worlds can draw from one pool. Not thread-safe: structural changes
+    already happen on one thread at a time, and worlds sharing an allocator have to keep it that way.
 */
-class PE_API Archetype
+class PE_API ChunkAllocator
 {
 public:
-    // Construct from a set of component IDs
-    Archetype(std::vector<int> compIDs)
-        : componentIDs(std::move(compIDs))
-    {
-        // Sort them for consistent ordering
-        std::sort(componentIDs.begin(), componentIDs.end());
-    }
+    virtual ~ChunkAllocator() = default;
+    virtual void* allocate(size_t bytes) = 0;
+    virtual void deallocate(void* ptr, size_t bytes) = 0;
+    // Give memory nobody is using back to the OS, returns how many bytes went. Optional
+    virtual size_t trim() { return 0; }
+};
 
-    // Store definition for the raw data buffer that holds each component's bytes
-    struct ComponentData {
-        int compID;
-        size_t componentSize;
-        std::vector<uint8_t> data; // SoA data
-    };
+/*
+    ===================
+    CHUNK ARENA
+    ===================
+    Default ChunkAllocator, each World owns one unless it's given another.
+    - Carves chunks out of big blocks (ARENA_BLOCK_SIZE) and keeps freed chunks on a free list per size,
+      so add/remove at a chunk boundary never reaches the heap.
+    - On Linux the blocks can be backed by huge pages: MAP_HUGETLB when the system has some reserved,
+      transparent huge pages otherwise. Fewer TLB misses when walking big archetypes.
+    - Destroying the arena frees every block at once, without visiting the chunks.
+    - trim() hands back blocks whose chunks are all on the free lists, e.g. after a large despawn.
+*/
+constexpr size_t ARENA_BLOCK_SIZE = 2 * 1024 * 1024;
 
-    // Initialize storage for a particular component ID (called once at creation time)
-    void initializeComponentStorage(int compID, size_t size)
+class PE_API ChunkArena : public ChunkAllocator
+{
+public:
+    explicit ChunkArena(bool hugePages = false, size_t blockBytes = ARENA_BLOCK_SIZE)
+        : hugePages(hugePages), blockBytes(blockBytes)
     {
-        ComponentData cData{ compID, size, {} };
-        compMap[compID] = static_cast<int>(components.size());
-        components.push_back(std::move(cData));
     }
 
-    // Check if this archetype has a given component ID
-    bool hasComponent(int compID) const {
-        return (compMap.find(compID) != compMap.end());
-    }
-
-    // Insert a new entity. Returns the index in the SoA buffers
-    size_t addEntity(Entity e)
+    ~ChunkArena() override
     {
-        size_t newIndex = entities.size();
-        entities.push_back(e);
-        entityToIndex[e.id] = newIndex;
-
-        // Expand each SoA data buffer by componentSize
-        for (auto& comp : components) {
-            size_t oldSizeBytes = comp.data.size();
-            size_t newSizeBytes = oldSizeBytes + comp.componentSize;
-            comp.data.resize(newSizeBytes, 0); // zero out new area
+        for (const Block& block : blocks) {
+            releaseBlock(block);
         }
-        return newIndex;
     }
 
-    // Remove an entity with typical "swap-and-pop" to maintain a tight array
-    void removeEntity(Entity e)
+    ChunkArena(const ChunkArena&) = delete;
+    ChunkArena& operator=(const ChunkArena&) = delete;
+
+    void* allocate(size_t bytes) override
     {
-        auto it = entityToIndex.find(e.id);
-        if (it == entityToIndex.end()) {
-            return; // Not in this archetype
+        bytes = roundUp(bytes);
+        std::vector<void*>& free = freeList(bytes);
+        if (!free.empty()) {
+            void* ptr = free.back();
+            free.pop_back();
+            return ptr;
         }
+        if (bytes > remaining) {
+            // Whatever is left of the current block stays unused
+            blocks.push_back(acquireBlock(std::max(bytes, blockBytes)));
+            cursor    = static_cast<uint8_t*>(blocks.back().memory);
+            remaining = blocks.back().size;
+        }
+        void* ptr = cursor;
+        cursor    += bytes;
+        remaining -= bytes;
+        blocks.back().carved += bytes;
+        return ptr;
+    }
 
-        size_t index     = it->second;
-        size_t lastIndex = entities.size() - 1;
+    void deallocate(void* ptr, size_t bytes) override
+    {
+        freeList(roundUp(bytes)).push_back(ptr);
+    }
 
-        if (index != lastIndex)
-        {
-            // Swap in the last entity
-            Entity lastEnt = entities[lastIndex];
-            entities[index] = lastEnt;
-            entityToIndex[lastEnt.id] = index;
+    size_t trim() override
+    {
+        // Free bytes per block. Blocks are few, so a sorted copy of their addresses does for the lookup
+        std::vector<size_t> order(blocks.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return std::less<void*>()(blocks[a].memory, blocks[b].memory);
+        });
+        auto owner = [&](void* ptr) {
+            auto it = std::upper_bound(order.begin(), order.end(), ptr, [&](void* p, size_t b) {
+                return std::less<void*>()(p, blocks[b].memory);
+            });
+            return *(it - 1);
+        };
+        std::vector<size_t> freeBytes(blocks.size(), 0);
+        for (const auto& [size, list] : freeLists) {
+            for (void* ptr : list) freeBytes[owner(ptr)] += size;
+        }
 
-            // Swap the SoA data for each component
-            for (auto& comp : components) {
-                size_t sizeBytes = comp.componentSize;
-                uint8_t* arr     = comp.data.data();
-                size_t offsetA   = index * sizeBytes;
-                size_t offsetB   = lastIndex * sizeBytes;
+        std::vector<bool> idle(blocks.size());
+        bool any = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            idle[b] = freeBytes[b] == blocks[b].carved;
+            any = any || idle[b];
+        }
+        if (!any) return 0;
 
-                for (size_t i = 0; i < sizeBytes; ++i) {
-                    std::swap(arr[offsetA + i], arr[offsetB + i]);
-                }
+        for (auto& [size, list] : freeLists) {
+            list.erase(std::remove_if(list.begin(), list.end(), [&](void* ptr) { return idle[owner(ptr)]; }), list.end());
+        }
+        if (!blocks.empty() && idle.back()) {
+            // The block being carved from goes too, the next allocation starts a fresh one
+            cursor    = nullptr;
+            remaining = 0;
+        }
+        size_t released = 0;
+        size_t kept = 0;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if (idle[b]) {
+                released += blocks[b].size;
+                releaseBlock(blocks[b]);
+            } else {
+                blocks[kept++] = blocks[b];
             }
         }
+        blocks.resize(kept);
+        return released;
+    }
 
-        // Pop the last entity
-        entities.pop_back();
-        entityToIndex.erase(e.id);
-
-        // Shrink each SoA data buffer
-        for (auto& comp : components) {
-            comp.data.resize(comp.data.size() - comp.componentSize);
-        }
+    // Bytes taken from the OS so far
+    size_t getReservedBytes() const
+    {
+        size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
     }
 
-    // Get pointer to the raw bytes of compID for entity e
-    // Returns nullptr if e not found or if compID not in this archetype
-    uint8_t* getComponentData(Entity e, int compID)
+    // Blocks that actually got huge pages (explicit or transparent)
+    size_t getHugePageBlockCount() const
     {
-        auto it = entityToIndex.find(e.id);
-        if (it == entityToIndex.end()) {
-            return nullptr;
-        }
-        auto compIt = compMap.find(compID);
-        if (compIt == compMap.end()) {
-            return nullptr;
-        }
-        size_t entityIndex = it->second;
-        int compVecIndex   = compIt->second;
-        ComponentData& c   = components[compVecIndex];
-        size_t offset      = entityIndex * c.componentSize;
-        return c.data.data() + offset;
+        return static_cast<size_t>(std::count_if(blocks.begin(), blocks.end(), [](const Block& b) { return b.hugePages; }));
     }
 
-    // Accessors
-    size_t getEntityCount() const { return entities.size(); }
-    const std::vector<Entity>& getEntities() const { return entities; }
-    const std::vector<int>& getComponentIDs() const { return componentIDs; }
+private:
+    struct Block {
+        void* memory;
+        size_t size;
+        bool mapped;    // From mmap rather than aligned new
+        bool hugePages;
+        size_t carved = 0; // Bytes handed out as chunks so far
+    };
 
-    // Publicly accessible only if needed (e.g., for moving data):
-    std::vector<ComponentData> components;
-    std::unordered_map<int, int> compMap;
+    // Platform specific, in SecsAllocator.cpp
+    Block acquireBlock(size_t bytes) const;
+    static void releaseBlock(const Block& block);
 
-private:
-    std::vector<int> componentIDs;
-    std::vector<Entity> entities;
-    std::unordered_map<uint32_t, size_t> entityToIndex;
+    static size_t roundUp(size_t bytes)
+    {
+        return (bytes + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+    }
+
+    // Chunks only come in a handful of sizes, a linear search beats a map here
+    std::vector<void*>& freeList(size_t bytes)
+    {
+        for (auto& [size, list] : freeLists) {
+            if (size == bytes) return list;
+        }
+        freeLists.emplace_back(bytes, std::vector<void*>{});
+        return freeLists.back().second;
+    }
+
+    bool hugePages;
+    size_t blockBytes;
+    std::vector<Block> blocks;
+    uint8_t* cursor  = nullptr;
+    size_t remaining = 0;
+    std::vector<std::pair<size_t, std::vector<void*>>> freeLists;
 };
 
+// Which value each Shared component of an archetype has, indexed by component ID. Values are
+// World-interned indices, 0 being the default-constructed value and the entry for any absent component
+using SharedKey = std::array<uint32_t, MAX_COMPONENTS>;
+
 /*
     ===================
-    WORLD
+    ARCHETYPE
     ===================
-    - Manages archetypes for every unique combination of components.
-    - Tracks which archetype each entity belongs to.
-    - Creates/destroys entities and moves them between archetypes as comps are added/removed.
+    Groups entities that have the same set of components (same signature).
+    Storage is split into fixed size chunks (CHUNK_SIZE bytes). Each chunk holds
+    every column for a block of entities in a SoA layout:
+        [Entity x capacity][CompA x capacity][CompB x capacity]...
+    Only the last chunk is ever partially filled, so add/remove touch one row per column.
+    Each chunk also keeps a change tick per column (stored after the columns), bumped by
+    anything that writes to the column: mutable query access, getComponent and rows moving in.
+    Every live row holds constructed values. Rows are moved with the component's ComponentOps,
+    which is a plain memcpy for trivially copyable types.
+    Also caches the "add X" / "remove X" transitions to neighbouring archetypes,
+    so after the first move between two archetypes it's just a pointer chase.
+    Chunks come from the World's ChunkAllocator, so every column starts on a cache line.
 */
-class PE_API World
+class PE_API Archetype
 {
 public:
-    World() = default;
-
-    // Prevent copying to avoid attempts to copy unique_ptr in archetypes map
-    World(const World&) = delete;
-    World& operator=(const World&) = delete;
-
-    // You may allow move semantics if desired
-    World(World&&) = default;
-    World& operator=(World&&) = default;
-
-    // Create entity with a set of component IDs
-    Entity createEntity(const std::vector<int>& compIDs)
+    // Construct from a component bitmask
+    explicit Archetype(const Signature& sig)
+        : signature(sig)
     {
-        Entity e{ nextEntityID++ };
-        Archetype* arch = getOrCreateArchetype(compIDs);
-        arch->addEntity(e);
-        entityArchetypeMap[e.id] = arch;
-        return e;
+        // Bits are walked low to high, so the IDs come out sorted
+        for (int id = 0; id < MAX_COMPONENTS; ++id) {
+            if (signature.test(id)) {
+                componentIDs.push_back(id);
+            }
+        }
+        addEdges.fill(nullptr);
+        removeEdges.fill(nullptr);
+        compMap.fill(-1);
+        sharedKey.fill(0);
     }
 
-    // Destroy an entity
-    void destroyEntity(Entity e)
+    ~Archetype()
     {
-        auto it = entityArchetypeMap.find(e.id);
-        if (it == entityArchetypeMap.end())
-        {
-            return; // Already destroyed or invalid
+        if (!trivialColumns()) {
+            for (auto& chunk : chunks) {
+                destroyRows(chunk, 0, chunk.count);
+            }
+        }
+        if (!allocator) return; // Abandoned, the memory goes away with its allocator
+        for (auto& chunk : chunks) {
+            allocator->deallocate(chunk.memory, chunkBytes);
         }
-        it->second->removeEntity(e);
-        entityArchetypeMap.erase(e.id);
     }
 
-    bool isAlive(Entity e) const
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    // Describes one column inside every chunk of this archetype
+    struct ComponentData {
+        int compID;
+        size_t componentSize;
+        size_t offset; // Byte offset of the column from the start of a chunk
+        ComponentOps ops;
+        const ComponentInfo* split = nullptr; // Field layout when the column is one array per field
+    };
+
+    // A block of entities, all columns live in one COLUMN_ALIGNMENT aligned allocation
+    struct Chunk {
+        uint8_t* memory = nullptr; // Owned by the archetype, comes from its ChunkAllocator
+        size_t count = 0;
+
+        Entity* entities() const { return reinterpret_cast<Entity*>(memory); }
+        uint8_t* column(const ComponentData& c) const { return memory + c.offset; }
+    };
+
+    // Initialize storage for a particular component ID (called once at creation time).
+    // split is the registry entry of a field-split component, see SplitFields
+    void initializeComponentStorage(int compID, size_t size, const ComponentOps& ops = {}, const ComponentInfo* split = nullptr)
     {
-        return (entityArchetypeMap.find(e.id) != entityArchetypeMap.end());
+        ComponentData cData{ compID, size, 0, ops, split };
+        compMap[compID] = static_cast<int>(components.size());
+        components.push_back(cData);
     }
 
-    // Add a component T to an entity (runtime)
-    template<typename T>
-    void addComponent(Entity e, const T& value = T{})
+    // Lay the columns out inside a chunk. Called once after all storage is initialized.
+    void buildChunkLayout()
     {
-        Archetype* oldArch = findArchetype(e);
-        if (!oldArch) return;
-
-        // Build new signature (old + T)
-        std::vector<int> newCompIDs = oldArch->getComponentIDs();
-        int newID = ComponentRegistry::getID<T>();
-        if (std::find(newCompIDs.begin(), newCompIDs.end(), newID) != newCompIDs.end()) {
-            // Already has it => Just overwrite
-            T* ptr = reinterpret_cast<T*>(oldArch->getComponentData(e, newID));
-            if (ptr) *ptr = value;
-            return;
+        size_t rowSize = sizeof(Entity);
+        for (auto& comp : components) {
+            rowSize += comp.componentSize;
         }
-        newCompIDs.push_back(newID);
 
-        Archetype* newArch = getOrCreateArchetype(newCompIDs);
-        moveEntityToArchetype(e, oldArch, newArch);
+        // Worst case every column needs COLUMN_ALIGNMENT - 1 bytes of padding, and the change ticks go last
+        size_t padding = COLUMN_ALIGNMENT * (components.size() + 1) + sizeof(uint32_t) * components.size();
+        chunkCapacity = CHUNK_SIZE > padding ? (CHUNK_SIZE - padding) / rowSize : 0;
+        if (chunkCapacity == 0) {
+            chunkCapacity = 1; // Huge components get a chunk of their own
+        }
 
-        // Set the newly added component data
-        T* ptr = reinterpret_cast<T*>(newArch->getComponentData(e, newID));
-        if (ptr) {
-            *ptr = value;
+        size_t offset = alignUp(sizeof(Entity) * chunkCapacity);
+        for (auto& comp : components) {
+            comp.offset = offset;
+            offset = alignUp(offset + comp.componentSize * chunkCapacity);
         }
+        ticksOffset = offset;
+        chunkBytes  = std::max(offset + sizeof(uint32_t) * components.size(), CHUNK_SIZE);
     }
 
-    // Remove a component T from an entity (runtime)
-    template<typename T>
-    void removeComponent(Entity e)
+    // World tick that writes get stamped with. Set once by World when it creates the archetype.
+    void setChangeTickSource(const uint32_t* tick) { changeTick = tick; }
+
+    // Where chunks come from. Set once by World when it creates the archetype.
+    void setAllocator(ChunkAllocator* chunkAllocator) { allocator = chunkAllocator; }
+
+    // Values of the Shared components, which have no column. Set once by World when it creates the archetype;
+    // value points into World's interned values
+    void setSharedValue(int compID, uint32_t index, const uint8_t* value)
     {
-        Archetype* oldArch = findArchetype(e);
-        if (!oldArch) return;
+        sharedKey[compID] = index;
+        sharedValues.push_back({ compID, value });
+    }
 
-        std::vector<int> newCompIDs = oldArch->getComponentIDs();
-        int remID = ComponentRegistry::getID<T>();
-        auto it   = std::find(newCompIDs.begin(), newCompIDs.end(), remID);
-        if (it == newCompIDs.end()) {
-            // Not present
-            return;
+    // The one value of a Shared component for every row, nullptr if compID isn't a shared component here
+    const uint8_t* getSharedValue(int compID) const
+    {
+        for (const auto& [id, value] : sharedValues) {
+            if (id == compID) return value;
         }
-        newCompIDs.erase(it);
+        return nullptr;
+    }
 
-        Archetype* newArch = getOrCreateArchetype(newCompIDs);
-        moveEntityToArchetype(e, oldArch, newArch);
-        // Now T is gone, as newArch doesn't contain that compID
+    const SharedKey& getSharedKey() const { return sharedKey; }
+
+    // Bumped whenever the archetype gains or loses a chunk (going from empty to not or back included),
+    // so queries know to re-pick the archetypes worth walking and recount their chunks.
+    // Set once by World when it creates the archetype.
+    void setOccupancyCounter(uint64_t* counter) { occupancyVersion = counter; }
+
+    // Forget the chunks without handing them back, for when the allocator is about to be dropped whole.
+    // Components still get destroyed when the archetype goes.
+    void abandonChunks() { allocator = nullptr; }
+
+    // Copy a chunk-shaped block: entity handles, change ticks and the first rows values of every column.
+    // dst is raw getChunkBytes() memory, src one of this archetype's chunks or a block copied from one
+    // (or from an archetype with the same signature in another World). Throws for columns that can't be copied.
+    void copyChunk(uint8_t* dst, const uint8_t* src, size_t rows) const
+    {
+        std::memcpy(dst, src, chunkBytes);
+        for (const auto& comp : components) {
+            if (comp.ops.trivialRelocate) continue;
+            if (!comp.ops.copy) {
+                throw std::runtime_error("Can't copy a chunk holding " + ComponentRegistry::getName(comp.compID) + ", it isn't copyable!");
+            }
+            comp.ops.copy(dst + comp.offset, src + comp.offset, rows);
+        }
     }
 
-    // Retrieve a component T from an entity
-    template<typename T>
-    T* getComponent(Entity e)
+    // Destroy the values of a block filled by copyChunk, the memory stays the caller's
+    void destroyChunkCopy(uint8_t* block, size_t rows) const
     {
-        Archetype* arch = findArchetype(e);
-        if (!arch) return nullptr;
+        for (const auto& comp : components) {
+            destroyValues(comp, block + comp.offset, rows);
+        }
+    }
 
-        int compID = ComponentRegistry::getID<T>();
-        uint8_t* bytes = arch->getComponentData(e, compID);
-        return reinterpret_cast<T*>(bytes);
+    // Make the rows count rows taken from blocks (see copyChunk), blocks[i] becoming chunk i.
+    // A chunk not written after sinceTick that already holds as many rows is left alone, it can't differ
+    // from a block copied at sinceTick. Every other chunk is overwritten and counts as written.
+    void restoreChunks(std::span<const uint8_t* const> blocks, size_t count, uint32_t sinceTick)
+    {
+        const bool trivial = trivialColumns();
+        while (chunks.size() > blocks.size()) {
+            if (!trivial) destroyRows(chunks.back(), 0, chunks.back().count);
+            releaseLastChunk();
+        }
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            const size_t rows = std::min(chunkCapacity, count - i * chunkCapacity);
+            if (i == chunks.size()) {
+                allocateChunk();
+            } else {
+                const uint32_t* ticks = columnTicks(chunks[i]);
+                const bool untouched = !components.empty() && chunks[i].count == rows
+                    && std::all_of(ticks, ticks + components.size(), [sinceTick](uint32_t tick) { return tick <= sinceTick; });
+                if (untouched) continue;
+                if (!trivial) destroyRows(chunks[i], 0, chunks[i].count);
+            }
+            copyChunk(chunks[i].memory, blocks[i], rows);
+            chunks[i].count = rows;
+            markRowsChanged(chunks[i]);
+        }
+        setEntityCount(count);
     }
 
-    // Let systems iterate archetypes if needed
-    const std::unordered_map<std::string, std::unique_ptr<Archetype>>& getAllArchetypes() const
+    // Per-column change ticks of a chunk, indexed like components
+    uint32_t* columnTicks(const Chunk& chunk) const
     {
-        return archetypes;
+        return reinterpret_cast<uint32_t*>(chunk.memory + ticksOffset);
     }
 
-private:
-    Archetype* findArchetype(Entity e)
+    // Stamp one column (index into components) of a chunk as written now
+    void markChanged(const Chunk& chunk, size_t column) const
     {
-        auto it = entityArchetypeMap.find(e.id);
-        if (it == entityArchetypeMap.end()) {
-            return nullptr;
-        }
-        return it->second;
+        columnTicks(chunk)[column] = currentTick();
     }
 
-    // Create/fetch archetype for a set of component IDs
-    Archetype* getOrCreateArchetype(const std::vector<int>& compIDs)
+    void markChanged(const EntityLocation& loc, int compID)
     {
-        std::string sig = buildSignature(compIDs);
-        auto it = archetypes.find(sig);
-        if (it != archetypes.end()) {
-            return it->second.get();
+        int column = compMap[compID];
+        if (column >= 0) {
+            markChanged(chunks[loc.chunk], static_cast<size_t>(column));
         }
+    }
 
-        // New archetype
-        auto newArch = std::make_unique<Archetype>(compIDs);
-        for (int cID : compIDs) {
-            size_t cSize = ComponentRegistry::getSize(cID);
-            newArch->initializeComponentStorage(cID, cSize);
+    // Same, for when other threads may stamp or read the same chunk at once (rows of a
+    // sparse-driven parallel query). Read those ticks with loadTick()
+    void markChangedShared(const EntityLocation& loc, int compID)
+    {
+        int column = compMap[compID];
+        if (column >= 0) {
+            std::atomic_ref<uint32_t>(columnTicks(chunks[loc.chunk])[column]).store(currentTick(), std::memory_order_relaxed);
         }
+    }
 
-        Archetype* ptr = newArch.get();
-        archetypes[sig] = std::move(newArch);
-        return ptr;
+    uint32_t loadTick(const Chunk& chunk, size_t column) const
+    {
+        return std::atomic_ref<uint32_t>(columnTicks(chunk)[column]).load(std::memory_order_relaxed);
     }
 
-    // Moves an entity between two archetypes, copying shared component data
-    void moveEntityToArchetype(Entity e, Archetype* oldArch, Archetype* newArch)
+    // Was compID of the row at loc written after sinceTick? Chunk granularity, like the queries
+    bool changedSince(const EntityLocation& loc, int compID, uint32_t sinceTick) const
     {
-        if (oldArch == newArch) return;
+        int column = compMap[compID];
+        return column >= 0 && columnTicks(chunks[loc.chunk])[column] > sinceTick;
+    }
 
-        // 1) Copy data for all overlapping components
-        auto& oldIDs = oldArch->getComponentIDs();
-        auto& newIDs = newArch->getComponentIDs();
+    // Check if this archetype has a given component ID (a column, or a shared value)
+    bool hasComponent(int compID) const {
+        return signature.test(compID);
+    }
 
-        // We'll store data temporarily here
-        std::unordered_map<int, std::vector<uint8_t>> transferData;
+    // Insert a new entity with default-constructed components. Returns where its row ended up
+    EntityLocation addEntity(Entity e)
+    {
+        EntityLocation loc = allocateRow(e);
+        for (auto& comp : components) {
+            constructRows(comp, chunks[loc.chunk].column(comp), chunkCapacity, loc.row, 1);
+        }
+        return loc;
+    }
 
-        // Collect data from old arch for components that exist in new arch
-        for (int cid : oldIDs)
-        {
-            if (std::find(newIDs.begin(), newIDs.end(), cid) != newIDs.end()) {
-                // Overlapping component
-                uint8_t* oldBytes = oldArch->getComponentData(e, cid);
-                if (oldBytes) {
-                    size_t cSize = ComponentRegistry::getSize(cid);
-                    transferData[cid].resize(cSize);
-                    std::memcpy(transferData[cid].data(), oldBytes, cSize);
-                }
-            }
+    // Insert a new entity but leave its components unconstructed.
+    // The caller has to construct (or relocate into) every column before anything else touches the row.
+    EntityLocation allocateRow(Entity e)
+    {
+        if (chunks.empty() || chunks.back().count == chunkCapacity) {
+            allocateChunk();
         }
+        Chunk& chunk = chunks.back();
+        size_t row = chunk.count++;
+        chunk.entities()[row] = e;
+        markRowsChanged(chunk);
+        setEntityCount(entityCount + 1);
+        return { static_cast<uint32_t>(chunks.size() - 1), static_cast<uint32_t>(row) };
+    }
 
-        // 2) Remove from old arch
-        oldArch->removeEntity(e);
+    // Append count rows in one go: top up the last chunk, then fill fresh ones.
+    // Components are default-constructed a column at a time. Returns where the first row went, the rest follow
+    // it in order (see advance()).
+    EntityLocation addEntities(const Entity* ents, size_t count)
+    {
+        return appendRows(ents, count, [this](Chunk& chunk, size_t row, size_t n, size_t) {
+            for (auto& comp : components) {
+                constructRows(comp, chunk.column(comp), chunkCapacity, row, n);
+            }
+        });
+    }
 
-        // 3) Add to new arch
-        newArch->addEntity(e);
+    // addEntities with the construction left to the caller: fill(chunk, row, n, placed) has to construct
+    // rows [row, row + n) of every column in chunk, placed is how many rows came before them.
+    // Lets a loader copy whole column blocks straight in.
+    template<typename Fill>
+    EntityLocation appendRows(const Entity* ents, size_t count, Fill&& fill)
+    {
+        if (count == 0) return {};
+        if (chunks.empty() || chunks.back().count == chunkCapacity) {
+            allocateChunk();
+        }
+        EntityLocation first{ static_cast<uint32_t>(chunks.size() - 1), static_cast<uint32_t>(chunks.back().count) };
 
-        // 4) Copy data into new arch
-        for (auto& [cid, buf] : transferData)
+        size_t placed = 0;
+        while (placed < count)
         {
-            uint8_t* newBytes = newArch->getComponentData(e, cid);
-            if (newBytes) {
-                std::memcpy(newBytes, buf.data(), buf.size());
+            if (chunks.back().count == chunkCapacity) {
+                allocateChunk();
             }
+            Chunk& chunk = chunks.back();
+            size_t row = chunk.count;
+            size_t n   = std::min(count - placed, chunkCapacity - row);
+
+            std::memcpy(chunk.entities() + row, ents + placed, n * sizeof(Entity));
+            fill(chunk, row, n, placed);
+            markRowsChanged(chunk);
+            chunk.count += n;
+            placed      += n;
         }
-
-        // 5) Update the map
-        entityArchetypeMap[e.id] = newArch;
+        setEntityCount(entityCount + count);
+        return first;
     }
 
-    uint32_t nextEntityID = 0;
-    std::unordered_map<std::string, std::unique_ptr<Archetype>> archetypes;
-    std::unordered_map<uint32_t, Archetype*> entityArchetypeMap;
-};
-
-/*
-    ===================
-    SYSTEM
-    ===================
-    - Has a list of required component IDs.
-    - On execute, it finds all archetypes containing them
-      and processes each matching entity with a user callback.
-*/
-class PE_API System
-{
-public:
-    using Callback = std::function<void(Entity, World&)>;
+    // Location n rows after loc, assuming every chunk in between is full
+    EntityLocation advance(EntityLocation loc, size_t n) const
+    {
+        size_t flat = flatRow(loc) + n;
+        return { static_cast<uint32_t>(flat / chunkCapacity), static_cast<uint32_t>(flat % chunkCapacity) };
+    }
 
-    System(std::vector<int> requiredCompIDs, Callback cb)
-        : requiredComponents(std::move(requiredCompIDs))
-        , callback(std::move(cb))
+    // Remove the row at loc with typical "swap-and-pop" to maintain a tight array.
+    // Returns true if another entity was moved into loc (its handle goes to movedEntity),
+    // so the caller can fix up that entity's location.
+    bool removeEntity(const EntityLocation& loc, Entity& movedEntity)
     {
-        std::sort(requiredComponents.begin(), requiredComponents.end());
+        destroyRows(chunks[loc.chunk], loc.row, 1);
+        return removeVacatedRow(loc, movedEntity);
     }
 
-    void execute(World& world)
+    // Same as removeEntity, for a row whose components were already moved out or destroyed
+    bool removeVacatedRow(const EntityLocation& loc, Entity& movedEntity)
     {
-        const auto& allArche = world.getAllArchetypes();
-        for (auto& [sig, archPtr] : allArche)
+        Chunk& chunk     = chunks[loc.chunk];
+        Chunk& lastChunk = chunks.back();
+        size_t lastRow   = lastChunk.count - 1;
+
+        bool moved = &chunk != &lastChunk || loc.row != lastRow;
+        if (moved)
         {
-            if (matchesAll(archPtr.get())) {
-                const auto& ents = archPtr->getEntities();
-                for (auto& e : ents) {
-                    callback(e, world);
+            // Move the last entity into the hole
+            movedEntity = lastChunk.entities()[lastRow];
+            relocateRow(chunk, loc.row, lastChunk, lastRow);
+        }
+
+        // Pop the last entity
+        --lastChunk.count;
+        setEntityCount(entityCount - 1);
+
+        if (lastChunk.count == 0) {
+            releaseLastChunk();
+        }
+        return moved;
+    }
+
+    // Remove many rows in one compaction pass. rows are flat row indices (see flatRow), sorted and unique.
+    // Every hole below the new end gets filled from the first surviving rows past it, then the
+    // tail is cut off in one go. onMoved(entity, newLocation) runs for each row that moved.
+    template<typename MovedCallback>
+    void removeEntities(const std::vector<size_t>& rows, MovedCallback&& onMoved)
+    {
+        if (rows.empty()) return;
+        const size_t newCount = entityCount - rows.size();
+
+        for (size_t row : rows) {
+            EntityLocation loc = advance({}, row);
+            destroyRows(chunks[loc.chunk], loc.row, 1);
+        }
+
+        // rows past newCount that are going away anyway, walked alongside the tail
+        auto doomed = std::lower_bound(rows.begin(), rows.end(), newCount);
+        size_t source = newCount;
+        for (auto hole = rows.begin(); hole != rows.end() && *hole < newCount; ++hole)
+        {
+            while (doomed != rows.end() && *doomed == source) {
+                ++doomed;
+                ++source;
+            }
+            EntityLocation from = advance({}, source++);
+            EntityLocation to   = advance({}, *hole);
+            Chunk& dst = chunks[to.chunk];
+            Chunk& src = chunks[from.chunk];
+            relocateRow(dst, to.row, src, from.row);
+            onMoved(dst.entities()[to.row], to);
+        }
+
+        // Cut the tail
+        size_t keptChunks = (newCount + chunkCapacity - 1) / chunkCapacity;
+        while (chunks.size() > keptChunks) {
+            releaseLastChunk();
+        }
+        if (!chunks.empty()) {
+            chunks.back().count = newCount - (keptChunks - 1) * chunkCapacity;
+        }
+        setEntityCount(newCount);
+    }
+
+    // Row index counting from the start of the first chunk. Only the last chunk is ever partial,
+    // so this is a stable order over the whole archetype
+    size_t flatRow(const EntityLocation& loc) const
+    {
+        return static_cast<size_t>(loc.chunk) * chunkCapacity + loc.row;
+    }
+
+    // Lifecycle of count consecutive values of one column, memcpy/memset when the type allows it
+    static void constructValues(const ComponentData& comp, uint8_t* dst, size_t count)
+    {
+        if (comp.ops.trivialConstruct) {
+            std::memset(dst, 0, count * comp.componentSize);
+        } else {
+            comp.ops.construct(dst, count);
+        }
+    }
+
+    static void relocateValues(const ComponentData& comp, uint8_t* dst, uint8_t* src, size_t count)
+    {
+        if (comp.ops.trivialRelocate) {
+            std::memcpy(dst, src, count * comp.componentSize);
+        } else {
+            comp.ops.relocate(dst, src, count);
+        }
+    }
+
+    static void destroyValues(const ComponentData& comp, uint8_t* ptr, size_t count)
+    {
+        if (!comp.ops.trivialRelocate) {
+            comp.ops.destroy(ptr, count);
+        }
+    }
+
+    // Copy-construct count values from src, or count copies of the single value at src
+    static void copyValues(const ComponentData& comp, uint8_t* dst, const uint8_t* src, size_t count)
+    {
+        if (comp.ops.trivialRelocate) {
+            std::memcpy(dst, src, count * comp.componentSize);
+        } else {
+            comp.ops.copy(dst, src, count);
+        }
+    }
+
+    static void fillValues(const ComponentData& comp, uint8_t* dst, const uint8_t* value, size_t count)
+    {
+        if (!comp.ops.trivialRelocate) {
+            comp.ops.fill(dst, value, count);
+            return;
+        }
+        repeat(dst, value, comp.componentSize, count);
+    }
+
+    // Same lifecycle by row, for whole-struct and field-split columns alike. column is where the column
+    // starts in a chunk (or any block laid out like one) of capacity rows; values outside it are whole structs.
+    // Split columns only ever hold trivially copyable types, so their rows are plain copies
+    static void constructRows(const ComponentData& comp, uint8_t* column, size_t capacity, size_t row, size_t count)
+    {
+        if (comp.split) {
+            fillRows(comp, column, capacity, row, comp.split->defaultValue, count);
+        } else {
+            constructValues(comp, column + row * comp.componentSize, count);
+        }
+    }
+
+    // Move count rows between two columns, src rows are left vacated
+    static void relocateRows(const ComponentData& comp, uint8_t* dst, size_t dstCapacity, size_t dstRow,
+                             uint8_t* src, size_t srcCapacity, size_t srcRow, size_t count)
+    {
+        if (!comp.split) {
+            relocateValues(comp, dst + dstRow * comp.componentSize, src + srcRow * comp.componentSize, count);
+            return;
+        }
+        for (size_t f = 0; f < comp.split->fieldCount; ++f) {
+            const FieldInfo& field = comp.split->fields[f];
+            std::memcpy(dst + field.start * dstCapacity + dstRow * field.size,
+                        src + field.start * srcCapacity + srcRow * field.size, count * field.size);
+        }
+    }
+
+    // Copy-construct count rows from another column, e.g. a prefab's
+    static void copyRows(const ComponentData& comp, uint8_t* dst, size_t dstCapacity, size_t dstRow,
+                         const uint8_t* src, size_t srcCapacity, size_t srcRow, size_t count)
+    {
+        if (comp.split) {
+            relocateRows(comp, dst, dstCapacity, dstRow, const_cast<uint8_t*>(src), srcCapacity, srcRow, count);
+        } else {
+            copyValues(comp, dst + dstRow * comp.componentSize, src + srcRow * comp.componentSize, count);
+        }
+    }
+
+    // Copy-construct count rows from the single struct at value
+    static void fillRows(const ComponentData& comp, uint8_t* column, size_t capacity, size_t row, const uint8_t* value, size_t count)
+    {
+        if (!comp.split) {
+            fillValues(comp, column + row * comp.componentSize, value, count);
+            return;
+        }
+        for (size_t f = 0; f < comp.split->fieldCount; ++f) {
+            const FieldInfo& field = comp.split->fields[f];
+            repeat(column + field.start * capacity + row * field.size, value + field.offset, field.size, count);
+        }
+    }
+
+    // Copy-construct count rows from count consecutive structs
+    static void scatterRows(const ComponentData& comp, uint8_t* column, size_t capacity, size_t row, const uint8_t* values, size_t count)
+    {
+        if (!comp.split) {
+            copyValues(comp, column + row * comp.componentSize, values, count);
+            return;
+        }
+        for (size_t f = 0; f < comp.split->fieldCount; ++f) {
+            const FieldInfo& field = comp.split->fields[f];
+            uint8_t* array = column + field.start * capacity + row * field.size;
+            for (size_t i = 0; i < count; ++i) {
+                std::memcpy(array + i * field.size, values + i * comp.componentSize + field.offset, field.size);
+            }
+        }
+    }
+
+    // Byte copies of count rows as consecutive structs. Trivially copyable types only
+    static void gatherRows(const ComponentData& comp, const uint8_t* column, size_t capacity, size_t row, uint8_t* out, size_t count)
+    {
+        if (!comp.split) {
+            std::memcpy(out, column + row * comp.componentSize, count * comp.componentSize);
+            return;
+        }
+        for (size_t f = 0; f < comp.split->fieldCount; ++f) {
+            const FieldInfo& field = comp.split->fields[f];
+            const uint8_t* array = column + field.start * capacity + row * field.size;
+            for (size_t i = 0; i < count; ++i) {
+                std::memcpy(out + i * comp.componentSize + field.offset, array + i * field.size, field.size);
+            }
+        }
+    }
+
+    // Get pointer to the raw bytes of compID for the row at loc.
+    // Returns nullptr if compID not in this archetype, or if it's field-split: those rows
+    // have no address of their own, see readRow/writeRow
+    uint8_t* getComponentData(const EntityLocation& loc, int compID)
+    {
+        int column = compMap[compID];
+        if (column < 0) {
+            return nullptr;
+        }
+        const ComponentData& c = components[column];
+        if (c.split) [[unlikely]] {
+            return nullptr;
+        }
+        return chunks[loc.chunk].column(c) + loc.row * c.componentSize;
+    }
+
+    // Start of compID's column in the chunk holding loc, nullptr if compID not in this archetype
+    uint8_t* getColumnData(const EntityLocation& loc, int compID)
+    {
+        int column = compMap[compID];
+        return column < 0 ? nullptr : chunks[loc.chunk].column(components[column]);
+    }
+
+    // Whole-struct copy of the trivially copyable compID out of / into the row at loc, whatever
+    // the column layout. compID has to be in this archetype
+    void readRow(const EntityLocation& loc, int compID, void* out) const
+    {
+        const ComponentData& comp = components[compMap[compID]];
+        gatherRows(comp, chunks[loc.chunk].column(comp), chunkCapacity, loc.row, static_cast<uint8_t*>(out), 1);
+    }
+
+    void writeRow(const EntityLocation& loc, int compID, const void* value)
+    {
+        const ComponentData& comp = components[compMap[compID]];
+        scatterRows(comp, chunks[loc.chunk].column(comp), chunkCapacity, loc.row, static_cast<const uint8_t*>(value), 1);
+    }
+
+    // Accessors
+    size_t getEntityCount() const { return entityCount; }
+    size_t getChunkCapacity() const { return chunkCapacity; }
+    size_t getChunkBytes() const { return chunkBytes; }
+
+    // Rows that moved in or out because a component was added or removed, since the last resetMoveCounts()
+    size_t getMovesIn() const { return movesIn; }
+    size_t getMovesOut() const { return movesOut; }
+    void countMove(bool in) { ++(in ? movesIn : movesOut); }
+    void resetMoveCounts() { movesIn = movesOut = 0; }
+    const std::vector<Chunk>& getChunks() const { return chunks; }
+    const std::vector<int>& getComponentIDs() const { return componentIDs; }
+    const Signature& getSignature() const { return signature; }
+
+    // Publicly accessible only if needed (e.g., for moving data):
+    std::vector<ComponentData> components;
+    // Component ID -> index into components, -1 if not present
+    std::array<int, MAX_COMPONENTS> compMap;
+
+    // Transition graph, filled lazily by World. Indexed by component ID.
+    std::array<Archetype*, MAX_COMPONENTS> addEdges;
+    std::array<Archetype*, MAX_COMPONENTS> removeEdges;
+
+private:
+    static size_t alignUp(size_t bytes)
+    {
+        return (bytes + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+    }
+
+    // Move one row (entity handle and every column) into a vacated row. src is left vacated.
+    void relocateRow(Chunk& dst, size_t dstRow, Chunk& src, size_t srcRow)
+    {
+        markRowsChanged(dst);
+        dst.entities()[dstRow] = src.entities()[srcRow];
+        for (auto& comp : components) {
+            relocateRows(comp, dst.column(comp), chunkCapacity, dstRow, src.column(comp), chunkCapacity, srcRow, 1);
+        }
+    }
+
+    // count copies of the size bytes at value. Doubling copies, log2(count) memcpys instead of count
+    static void repeat(uint8_t* dst, const uint8_t* value, size_t size, size_t count)
+    {
+        if (count == 0 || size == 0) return;
+        std::memcpy(dst, value, size);
+        for (size_t filled = 1; filled < count;) {
+            size_t n = std::min(filled, count - filled);
+            std::memcpy(dst + filled * size, dst, n * size);
+            filled += n;
+        }
+    }
+
+    void destroyRows(Chunk& chunk, size_t row, size_t count)
+    {
+        for (auto& comp : components) {
+            destroyValues(comp, chunk.column(comp) + row * comp.componentSize, count);
+        }
+    }
+
+    // Rows moved into the chunk count as a write to every column
+    void markRowsChanged(const Chunk& chunk) const
+    {
+        std::fill_n(columnTicks(chunk), components.size(), currentTick());
+    }
+
+    uint32_t currentTick() const { return changeTick ? *changeTick : 0; }
+
+    void setEntityCount(size_t count)
+    {
+        if ((entityCount == 0) != (count == 0) && occupancyVersion) {
+            ++*occupancyVersion;
+        }
+        entityCount = count;
+    }
+
+    // Nothing to run when rows die
+    bool trivialColumns() const
+    {
+        return std::all_of(components.begin(), components.end(), [](const ComponentData& c) { return c.ops.trivialRelocate; });
+    }
+
+    void allocateChunk()
+    {
+        Chunk chunk;
+        chunk.memory = static_cast<uint8_t*>(allocator->allocate(chunkBytes));
+        chunks.push_back(chunk);
+        if (occupancyVersion) ++*occupancyVersion;
+    }
+
+    void releaseLastChunk()
+    {
+        allocator->deallocate(chunks.back().memory, chunkBytes);
+        chunks.pop_back();
+        if (occupancyVersion) ++*occupancyVersion;
+    }
+
+    Signature signature;
+    std::vector<int> componentIDs;
+    std::vector<Chunk> chunks;
+    ChunkAllocator* allocator = nullptr;
+    size_t chunkCapacity = 1;
+    size_t chunkBytes    = CHUNK_SIZE;
+    size_t ticksOffset   = 0;
+    size_t entityCount   = 0;
+    size_t movesIn       = 0;
+    size_t movesOut      = 0;
+    const uint32_t* changeTick = nullptr;
+    uint64_t* occupancyVersion = nullptr;
+    SharedKey sharedKey;
+    std::vector<std::pair<int, const uint8_t*>> sharedValues; // Few, a linear search beats a map
+};
+
+/*
+    ===================
+    SPARSE SET
+    ===================
+    Storage for one StorageKind::Sparse component type, outside the archetypes.
+    - sparse maps Entity::id -> index into the packed dense arrays.
+    - Adding and removing are O(1), removal is swap-and-pop. The entity's row never moves.
+    - Zero-size tags keep no values at all, just the entity list.
+*/
+class PE_API SparseSet
+{
+public:
+    SparseSet(int compID, size_t componentSize, const ComponentOps& ops)
+        : column{ compID, componentSize, 0, ops }
+    {
+    }
+
+    ~SparseSet()
+    {
+        Archetype::destroyValues(column, values.get(), dense.size());
+    }
+
+    SparseSet(const SparseSet&) = delete;
+    SparseSet& operator=(const SparseSet&) = delete;
+
+    bool contains(Entity e) const
+    {
+        return e.id < sparse.size() && sparse[e.id] != NONE && dense[sparse[e.id]] == e;
+    }
+
+    // Value of e, nullptr if it isn't in the set
+    void* get(Entity e)
+    {
+        return contains(e) ? valueAt(sparse[e.id]) : nullptr;
+    }
+
+    // Value of e, default-constructed first if it isn't in the set yet
+    void* emplace(Entity e)
+    {
+        if (contains(e)) return valueAt(sparse[e.id]);
+        if (e.id >= sparse.size()) {
+            sparse.resize(static_cast<size_t>(e.id) + 1, NONE);
+        }
+        if (dense.size() == capacity) {
+            grow();
+        }
+        sparse[e.id] = static_cast<uint32_t>(dense.size());
+        dense.push_back(e);
+        void* value = valueAt(dense.size() - 1);
+        Archetype::constructValues(column, static_cast<uint8_t*>(value), 1);
+        return value;
+    }
+
+    // Returns false if e wasn't in the set
+    bool remove(Entity e)
+    {
+        if (!contains(e)) return false;
+        const size_t index = sparse[e.id];
+        const size_t last  = dense.size() - 1;
+        Archetype::destroyValues(column, valueAt(index), 1);
+        if (index != last) {
+            Archetype::relocateValues(column, valueAt(index), valueAt(last), 1);
+            dense[index] = dense[last];
+            sparse[dense[index].id] = static_cast<uint32_t>(index);
+        }
+        dense.pop_back();
+        sparse[e.id] = NONE;
+        return true;
+    }
+
+    size_t size() const { return dense.size(); }
+    const Entity* entities() const { return dense.data(); }
+
+    // Reallocate the values to fit what's left, returns the bytes freed
+    size_t shrinkToFit()
+    {
+        const size_t fitted = dense.empty() ? 0 : std::max<size_t>(dense.size(), 64);
+        if (fitted >= capacity || column.componentSize == 0) return 0;
+        const size_t freed = (capacity - fitted) * column.componentSize;
+        std::unique_ptr<uint8_t[]> shrunk;
+        if (fitted > 0) {
+            shrunk = std::make_unique<uint8_t[]>(fitted * column.componentSize);
+            Archetype::relocateValues(column, shrunk.get(), values.get(), dense.size());
+        }
+        values   = std::move(shrunk);
+        capacity = fitted;
+        dense.shrink_to_fit();
+        return freed;
+    }
+    int getComponentID() const { return column.compID; }
+
+    uint8_t* valueAt(size_t index) const
+    {
+        return values.get() + index * column.componentSize;
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    void grow()
+    {
+        capacity = std::max<size_t>(capacity * 2, 64);
+        if (column.componentSize == 0) {
+            // Every tag shares one address, it only has to be non-null
+            if (!values) values = std::make_unique<uint8_t[]>(1);
+            return;
+        }
+        auto grown = std::make_unique<uint8_t[]>(capacity * column.componentSize);
+        if (!dense.empty()) {
+            Archetype::relocateValues(column, grown.get(), values.get(), dense.size());
+        }
+        values = std::move(grown);
+    }
+
+    Archetype::ComponentData column; // Same lifecycle helpers as an archetype column
+    std::vector<uint32_t> sparse;
+    std::vector<Entity> dense;
+    std::unique_ptr<uint8_t[]> values;
+    size_t capacity = 0;
+};
+
+template<typename... Components>
+class Query;
+
+// Query terms besides plain components, see QUERY below
+template<typename T> struct Optional {}; // T* in the callback, nullptr for chunks without T
+template<typename T> struct With {};     // Has to have T, not handed out
+template<typename T> struct Without {};  // Must not have T
+template<typename T> struct Changed {};  // Has T and its column was written after the tick given to Query::since()
+template<typename T> struct Shared {};   // StorageKind::Shared T, const T* to the archetype's one value
+template<typename T> struct Split {};    // Field-split T (see SplitFields), a SplitColumn<T> of per-field arrays
+
+// A field-split column as query callbacks get it: one array per field of T, indexed by row like any column.
+//     [](const Entity*, SplitColumn<Velocity> velocities, size_t count) {
+//         float* x = velocities.get<&Velocity::x>();
+//         const float* dx = velocities.get<&Velocity::dx>();
+//         for (size_t i = 0; i < count; ++i) x[i] += dx[i];
+//     }
+// Const T hands out const arrays. Where an array starts is known at compile time, get() is one multiply-add.
+template<typename T>
+class SplitColumn
+{
+public:
+    using Value = std::remove_const_t<T>;
+    using Byte  = std::conditional_t<std::is_const_v<T>, const uint8_t, uint8_t>;
+
+    SplitColumn(Byte* column, size_t capacity, size_t row) : column(column), capacity(capacity), row(row) {}
+
+    // Array of the field Member, e.g. get<&Velocity::x>()
+    template<auto Member>
+    auto* get() const
+    {
+        using Field = std::remove_cvref_t<decltype(std::declval<Value&>().*Member)>;
+        using Pointer = std::conditional_t<std::is_const_v<T>, const Field*, Field*>;
+        constexpr size_t start = fieldStart<Member>();
+        return reinterpret_cast<Pointer>(column + start * capacity + row * sizeof(Field));
+    }
+
+private:
+    // Sizes of the fields before Member, same sum as FieldInfo::start
+    template<auto Member>
+    static constexpr size_t fieldStart()
+    {
+        size_t start = 0;
+        bool found   = false;
+        std::apply([&](auto... members) {
+            ([&] {
+                if (found) return;
+                if constexpr (std::is_same_v<decltype(members), decltype(Member)>) {
+                    if (members == Member) {
+                        found = true;
+                        return;
+                    }
+                }
+                start += sizeof(std::remove_cvref_t<decltype(std::declval<Value&>().*members)>);
+            }(), ...);
+        }, SplitFields<Value>::members);
+        if (!found) throw std::logic_error("Not one of the SplitFields members");
+        return start;
+    }
+
+    Byte* column;
+    size_t capacity;
+    size_t row; // First row handed out, 0 unless the query goes entity by entity
+};
+
+// Type-erased base so World can own queries of any shape
+class PE_API QueryBase
+{
+public:
+    virtual ~QueryBase() = default;
+};
+
+class CommandBuffer;
+
+// Where a deferred command was recorded, see World::getCommandSource()
+struct PE_API CommandSource {
+    uint32_t system = 0; // Index in the schedule plus one, 0 outside of systems
+    uint32_t phase  = 0; // Bumped around every parallel query the system runs
+    uint32_t job    = 0; // Index of the parallel job plus one, 0 outside of one
+
+    bool operator<(const CommandSource& other) const
+    {
+        return std::tie(system, phase, job) < std::tie(other.system, other.phase, other.job);
+    }
+};
+
+/*
+    ===================
+    STATS
+    ===================
+    Snapshot of how the world's memory is spread out, for the stats window and JSON dumps.
+    Allocated bytes count whole chunks; slack is allocated rows nobody lives in.
+*/
+struct PE_API ColumnStats {
+    std::string name;
+    size_t componentSize  = 0;
+    size_t usedBytes      = 0; // componentSize * live rows
+    size_t allocatedBytes = 0; // componentSize * allocated rows
+};
+
+struct PE_API ArchetypeStats {
+    std::string signature; // Component names joined with '|', "<empty>" for no components
+    size_t entityCount    = 0;
+    size_t chunkCount     = 0;
+    size_t chunkCapacity  = 0; // Rows per chunk
+    size_t slackRows      = 0;
+    size_t allocatedBytes = 0; // Chunks * chunk bytes, padding and change ticks included
+    size_t movesIn        = 0; // Since the last World::resetFrameStats()
+    size_t movesOut       = 0;
+    std::vector<ColumnStats> columns;
+};
+
+struct PE_API SparseSetStats {
+    std::string name;
+    size_t entityCount = 0;
+    size_t usedBytes   = 0;
+};
+
+class World;
+
+/*
+    ===================
+    PREFAB
+    ===================
+    Template for spawning many identical entities, made by World::makePrefab().
+    - Resolves the archetype once and keeps every column's initial value pre-laid-out, so
+      World::instantiate() writes a run of rows with one memcpy per column per chunk.
+      Trivial columns keep a full chunk's worth of copies for that; others keep one value that
+      gets copy-constructed into each row.
+    - Sparse components are kept aside and emplaced per entity.
+    - Only valid with the world that made it, which has to outlive it.
+*/
+class PE_API Prefab
+{
+public:
+    Prefab() = default;
+    ~Prefab() { release(); }
+
+    Prefab(const Prefab&) = delete;
+    Prefab& operator=(const Prefab&) = delete;
+
+    // A moved-from prefab is invalid, like a default-constructed one
+    Prefab(Prefab&& other) noexcept
+        : world(std::exchange(other.world, nullptr))
+        , archetype(std::exchange(other.archetype, nullptr))
+        , columns(std::move(other.columns))
+        , sparse(std::move(other.sparse))
+    {
+    }
+
+    Prefab& operator=(Prefab&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            world     = std::exchange(other.world, nullptr);
+            archetype = std::exchange(other.archetype, nullptr);
+            columns   = std::move(other.columns);
+            sparse    = std::move(other.sparse);
+        }
+        return *this;
+    }
+
+    bool isValid() const { return archetype != nullptr; }
+    Archetype* getArchetype() const { return archetype; }
+
+    // Initial value of compID, nullptr if the prefab doesn't have it
+    const void* getValue(int compID) const
+    {
+        for (const Value& v : columns) {
+            if (v.column.compID == compID) return v.data.get();
+        }
+        for (const Value& v : sparse) {
+            if (v.column.compID == compID) return v.data.get();
+        }
+        return archetype ? archetype->getSharedValue(compID) : nullptr;
+    }
+
+private:
+    friend class World;
+
+    struct Value {
+        Archetype::ComponentData column; // Offset matches the archetype's column
+        std::unique_ptr<uint8_t[]> data;
+        size_t rows = 0;                 // Copies laid out in data
+    };
+
+    void release()
+    {
+        for (Value& v : columns) Archetype::destroyValues(v.column, v.data.get(), v.rows);
+        for (Value& v : sparse)  Archetype::destroyValues(v.column, v.data.get(), v.rows);
+        columns.clear();
+        sparse.clear();
+    }
+
+    World* world = nullptr;
+    Archetype* archetype = nullptr;
+    std::vector<Value> columns; // One per archetype column, in the archetype's order
+    std::vector<Value> sparse;
+};
+
+/*
+    ===================
+    HOOKS
+    ===================
+    Callbacks World runs when an entity gains, loses or changes a component, so something
+    derived from the components (an index, a cache) can follow along instead of rescanning.
+    - Add runs once the value is in place, whichever way it got there: createEntity/createEntities,
+      instantiate, addComponent, flushCommands or Snapshot::Load.
+    - Remove runs while the value is still readable, destroying the entity included.
+    - Change of a table component is reported by World::publishChanges() from the change ticks, so it
+      has their chunk granularity: every row of a written chunk counts. Sparse and shared components
+      have no ticks, theirs run when addComponent (or a flushed add) replaces the value.
+    Hooks run on whichever thread makes the change and must not change the world's structure
+    themselves (record into commands() instead), nor add or remove hooks.
+*/
+enum class HookEvent : uint8_t { Add, Remove, Change };
+
+// Returned by World::addHook, to take the hook out again
+using HookID = uint32_t;
+
+/*
+    ===================
+    WORLD
+    ===================
+    - Manages archetypes for every unique combination of components.
+    - Tracks which archetype and row each entity lives in with a flat table indexed by Entity::id.
+    - Destroyed slots go to a free list and get reused with a bumped generation.
+    - Creates/destroys entities and moves them between archetypes as comps are added/removed.
+    - Structural changes invalidate chunk pointers, so code that's iterating records them
+      in a CommandBuffer instead and they get applied at the next flushCommands().
+    - Runs the hooks registered for the components that come and go (see HOOKS).
+*/
+class PE_API World
+{
+public:
+    // Chunks come from an arena of the world's own, freed in one go with it
+    World();
+    // Chunks come from allocator, which the world takes over (e.g. a ChunkArena with huge pages)
+    explicit World(std::unique_ptr<ChunkAllocator> allocator);
+    // Chunks come from a pool shared with other worlds. It has to outlive this one,
+    // every chunk is handed back to it on teardown
+    explicit World(ChunkAllocator& sharedAllocator);
+    ~World();
+
+    // Prevent copying to avoid attempts to copy unique_ptr in archetypes
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // No moving either, cached queries keep a pointer back to their World
+    World(World&&) = delete;
+    World& operator=(World&&) = delete;
+
+    // Create entity with a set of component IDs
+    Entity createEntity(const std::vector<int>& compIDs)
+    {
+        Entity e = allocateEntity();
+        Archetype* arch = getOrCreateArchetype(tableSignature(compIDs));
+        EntityRecord& record = entityRecords[e.id];
+        record.archetype = arch;
+        record.location  = arch->addEntity(e);
+        emplaceSparse(compIDs, { &e, 1 });
+        notify(HookEvent::Add, buildSignature(compIDs), { &e, 1 });
+        return e;
+    }
+
+    // Destroy an entity
+    void destroyEntity(Entity e)
+    {
+        if (!isAlive(e))
+        {
+            return; // Already destroyed or invalid
+        }
+        EntityRecord& record = entityRecords[e.id];
+        if (hookedComponents[size_t(HookEvent::Remove)].any()) {
+            notify(HookEvent::Remove, componentsOf(e), { &e, 1 });
+        }
+        removeRow(record.archetype, record.location);
+        for (SparseSet* set : activeSparseSets) {
+            set->remove(e);
+        }
+        releaseSlot(e.id);
+    }
+
+    // Create count entities straight in the archetype for compIDs, components default-constructed.
+    // One archetype lookup and one block append, no per-entity moves.
+    std::vector<Entity> createEntities(size_t count, const std::vector<int>& compIDs)
+    {
+        std::vector<Entity> created;
+        createEntitiesIn(getOrCreateArchetype(tableSignature(compIDs)), count, created);
+        emplaceSparse(compIDs, created);
+        notify(HookEvent::Add, buildSignature(compIDs), created);
+        return created;
+    }
+
+    // Same, with every row starting out as values, written a column at a time:
+    //     world.createEntities(400, Transform{}, Mesh{...}, AABB{...});
+    template<typename... Components>
+    std::vector<Entity> createEntities(size_t count, const Components&... values)
+    {
+        SharedKey key{};
+        (keyShared(key, values), ...);
+        Archetype* arch = getOrCreateArchetype(tableSignature({ ComponentRegistry::getID<Components>()... }), key);
+        std::vector<Entity> created;
+        EntityLocation first = createEntitiesIn(arch, count, created);
+        (fillComponent(arch, first, created, values), ...);
+        notify(HookEvent::Add, buildSignature({ ComponentRegistry::getID<Components>()... }), created);
+        return created;
+    }
+
+    // Capture values as a template for instantiate(). Components the values don't cover aren't in it:
+    //     secs::Prefab tree = world.makePrefab(Transform{}, Mesh{...}, Material{...}, AABB{...});
+    template<typename... Components>
+    Prefab makePrefab(const Components&... values)
+    {
+        SharedKey key{};
+        (keyShared(key, values), ...);
+        Prefab prefab;
+        prefab.world     = this;
+        prefab.archetype = getOrCreateArchetype(tableSignature({ ComponentRegistry::getID<Components>()... }), key);
+        for (const auto& comp : prefab.archetype->components) {
+            // Placeholders, so the order matches the archetype's columns whatever order values came in
+            prefab.columns.push_back({ comp, nullptr, 0 });
+        }
+        (capturePrefabValue(prefab, values), ...);
+        return prefab;
+    }
+
+    // Create count entities from prefab in one block append. Returns the handles in row order.
+    std::vector<Entity> instantiate(const Prefab& prefab, size_t count)
+    {
+        return instantiateRows(prefab, count, -1, nullptr);
+    }
+
+    // Same, one entity per element of overrides, which replaces the prefab's T:
+    //     world.instantiate(tree, std::span<const Transform>(placements));
+    // T still has to be one of the prefab's components, and not a Shared one.
+    template<typename T>
+    std::vector<Entity> instantiate(const Prefab& prefab, std::span<const T> overrides)
+    {
+        return instantiateRows(prefab, overrides.size(), ComponentRegistry::getID<T>(), reinterpret_cast<const uint8_t*>(overrides.data()));
+    }
+
+    // Destroy many entities at once. Rows are removed per archetype in one compaction pass
+    // instead of a swap-and-pop each. Dead handles and duplicates are skipped.
+    void destroyEntities(std::span<const Entity> entities)
+    {
+        struct Doomed {
+            Archetype* archetype;
+            size_t row;
+        };
+        std::vector<Doomed> doomed;
+        doomed.reserve(entities.size());
+        const bool hooked = hookedComponents[size_t(HookEvent::Remove)].any();
+        for (Entity e : entities) {
+            if (!isAlive(e)) continue;
+            if (hooked) notify(HookEvent::Remove, componentsOf(e), { &e, 1 });
+            EntityRecord& record = entityRecords[e.id];
+            doomed.push_back({ record.archetype, record.archetype->flatRow(record.location) });
+            for (SparseSet* set : activeSparseSets) {
+                set->remove(e);
+            }
+            releaseSlot(e.id); // Dead from here on, so a duplicate handle won't be picked up twice
+        }
+        std::sort(doomed.begin(), doomed.end(), [](const Doomed& a, const Doomed& b) {
+            return a.archetype != b.archetype ? std::less<Archetype*>()(a.archetype, b.archetype) : a.row < b.row;
+        });
+
+        std::vector<size_t> rows;
+        for (size_t begin = 0; begin < doomed.size();)
+        {
+            Archetype* arch = doomed[begin].archetype;
+            rows.clear();
+            size_t end = begin;
+            for (; end < doomed.size() && doomed[end].archetype == arch; ++end) {
+                rows.push_back(doomed[end].row);
+            }
+            arch->removeEntities(rows, [this](Entity moved, const EntityLocation& loc) {
+                entityRecords[moved.id].location = loc;
+            });
+            begin = end;
+        }
+    }
+
+    bool isAlive(Entity e) const
+    {
+        return e.id < entityRecords.size()
+            && entityRecords[e.id].generation == e.generation
+            && entityRecords[e.id].archetype != nullptr;
+    }
+
+    // Add a component T to an entity (runtime)
+    template<typename T>
+    void addComponent(Entity e, const T& value = T{})
+    {
+        EntityRecord* record = findRecord(e);
+        if (!record) return;
+        Archetype* oldArch = record->archetype;
+
+        int newID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isSparse(newID)) {
+            // Lives next to the archetype, the row stays where it is
+            SparseSet& set = getSparseSet(newID);
+            const bool had = set.contains(e);
+            *static_cast<T*>(set.emplace(e)) = value;
+            notifyOne(had ? HookEvent::Change : HookEvent::Add, newID, e);
+            return;
+        }
+        if (ComponentRegistry::isShared(newID)) {
+            // The value picks the archetype. Same value as before => stays put
+            Archetype* target = getSharedTarget(oldArch, newID, &value);
+            moveEntityToArchetype(e, *record, target);
+            if (!oldArch->hasComponent(newID)) {
+                notifyOne(HookEvent::Add, newID, e);
+            } else if (target != oldArch) {
+                notifyOne(HookEvent::Change, newID, e);
+            }
+            return;
+        }
+        if (oldArch->hasComponent(newID)) {
+            // Already has it => Just overwrite
+            assignComponent(oldArch, record->location, newID, value);
+            oldArch->markChanged(record->location, newID);
+            return;
+        }
+
+        Archetype* newArch = getAddTarget(oldArch, newID);
+        moveEntityToArchetype(e, *record, newArch);
+
+        // Set the newly added component data
+        assignComponent(newArch, record->location, newID, value);
+        notifyOne(HookEvent::Add, newID, e);
+    }
+
+    // Remove a component T from an entity (runtime)
+    template<typename T>
+    void removeComponent(Entity e)
+    {
+        EntityRecord* record = findRecord(e);
+        if (!record) return;
+        Archetype* oldArch = record->archetype;
+
+        int remID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isSparse(remID)) {
+            SparseSet& set = getSparseSet(remID);
+            if (set.contains(e)) {
+                notifyOne(HookEvent::Remove, remID, e);
+                set.remove(e);
+            }
+            return;
+        }
+        if (!oldArch->hasComponent(remID)) {
+            // Not present
+            return;
+        }
+
+        notifyOne(HookEvent::Remove, remID, e);
+        Archetype* newArch = getRemoveTarget(oldArch, remID);
+        moveEntityToArchetype(e, *record, newArch);
+        // Now T is gone, as newArch doesn't contain that compID
+    }
+
+    // Retrieve a component T from an entity, nullptr if it's dead or doesn't have one.
+    // Counts as a write for change tracking unless T is const. Shared components can only
+    // be read this way, addComponent changes them. Field-split ones have no address to hand
+    // out at all, see getComponentValue.
+    template<typename T>
+    T* getComponent(Entity e)
+    {
+        EntityRecord* record = findRecord(e);
+        if (!record) return nullptr;
+
+        int compID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isSparse(compID)) {
+            return static_cast<T*>(getSparseSet(compID).get(e));
+        }
+        if (ComponentRegistry::isShared(compID)) {
+            if constexpr (std::is_const_v<T>) {
+                return reinterpret_cast<T*>(record->archetype->getSharedValue(compID));
+            } else {
+                throw std::runtime_error("Shared components are read-only, use getComponent<const T> and addComponent!");
+            }
+        }
+        uint8_t* bytes = record->archetype->getComponentData(record->location, compID);
+        if (!bytes && ComponentRegistry::isSplit(compID) && record->archetype->hasComponent(compID)) {
+            throw std::runtime_error("Split components have no per-entity address, use getComponentValue and addComponent!");
+        }
+        if constexpr (!std::is_const_v<T>) {
+            if (bytes) record->archetype->markChanged(record->location, compID);
+        }
+        return reinterpret_cast<T*>(bytes);
+    }
+
+    // Copy of e's T whatever its storage, empty if e is dead or doesn't have one.
+    // The way to read a single field-split component outside a query
+    template<typename T>
+    std::optional<std::remove_const_t<T>> getComponentValue(Entity e)
+    {
+        using Value = std::remove_const_t<T>;
+        EntityRecord* record = findRecord(e);
+        if (!record) return std::nullopt;
+
+        const int compID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isSplit(compID)) {
+            if (!record->archetype->hasComponent(compID)) return std::nullopt;
+            Value value;
+            record->archetype->readRow(record->location, compID, &value);
+            return value;
+        }
+        const Value* ptr = getComponent<const Value>(e);
+        return ptr ? std::optional<Value>(*ptr) : std::nullopt;
+    }
+
+    // Run hook(e) on event for compID (see HOOKS). Hooks of the same event and component run in the
+    // order they were added
+    HookID addHook(HookEvent event, int compID, std::function<void(Entity)> hook)
+    {
+        if (!ComponentRegistry::isRegistered(compID)) {
+            throw std::runtime_error("Hook on a component that isn't registered!");
+        }
+        const HookID id = nextHookID++;
+        hooks[size_t(event)][compID].push_back({ id, std::move(hook) });
+        hookedComponents[size_t(event)].set(compID);
+        return id;
+    }
+
+    // Typed versions, hook(Entity e, const T& value) gets e's value:
+    //     world.onAdd<Name>([&](secs::Entity e, const Name& n) { byName[n.name] = e; });
+    template<typename T, typename Hook>
+    HookID onAdd(Hook hook) { return addHook(HookEvent::Add, ComponentRegistry::getID<T>(), typedHook<T>(std::move(hook))); }
+
+    template<typename T, typename Hook>
+    HookID onRemove(Hook hook) { return addHook(HookEvent::Remove, ComponentRegistry::getID<T>(), typedHook<T>(std::move(hook))); }
+
+    template<typename T, typename Hook>
+    HookID onChange(Hook hook) { return addHook(HookEvent::Change, ComponentRegistry::getID<T>(), typedHook<T>(std::move(hook))); }
+
+    // Take a hook out again. Unknown IDs are ignored
+    void removeHook(HookID id)
+    {
+        for (size_t event = 0; event < hooks.size(); ++event) {
+            for (int compID = 0; compID < MAX_COMPONENTS; ++compID) {
+                auto& list = hooks[event][compID];
+                auto it = std::find_if(list.begin(), list.end(), [id](const HookSlot& slot) { return slot.id == id; });
+                if (it == list.end()) continue;
+                list.erase(it);
+                if (list.empty()) hookedComponents[event].reset(compID);
+                return;
+            }
+        }
+    }
+
+    // Run the Change hooks for every table component written since the last call, a chunk's rows
+    // at a time. Closes the current change tick like advanceChangeTick(), so once per frame after
+    // the systems and the flush. Not while anything iterates the world.
+    void publishChanges()
+    {
+        const uint32_t since = publishedTick;
+        publishedTick = advanceChangeTick();
+        const Signature hooked = hookedComponents[size_t(HookEvent::Change)];
+        if (hooked.none()) return;
+
+        for (Archetype* arch : archetypeList)
+        {
+            if ((arch->getSignature() & hooked).none()) continue;
+            for (const Archetype::Chunk& chunk : arch->getChunks())
+            {
+                const uint32_t* ticks = arch->columnTicks(chunk);
+                for (size_t column = 0; column < arch->components.size(); ++column)
+                {
+                    const int compID = arch->components[column].compID;
+                    if (hooked.test(compID) && ticks[column] > since) {
+                        runHooks(HookEvent::Change, compID, { chunk.entities(), chunk.count });
+                    }
+                }
+            }
+        }
+    }
+
+    // fn(e) for every live entity that has compID, whatever its storage. fn must not change
+    // the world's structure
+    template<typename Fn>
+    void forEachWith(int compID, Fn&& fn)
+    {
+        if (ComponentRegistry::isSparse(compID)) {
+            SparseSet* set = sparseSets[compID].get();
+            if (!set) return;
+            for (size_t i = 0; i < set->size(); ++i) fn(set->entities()[i]);
+            return;
+        }
+        for (Archetype* arch : archetypeList)
+        {
+            if (!arch->hasComponent(compID)) continue;
+            for (const Archetype::Chunk& chunk : arch->getChunks()) {
+                for (size_t row = 0; row < chunk.count; ++row) fn(chunk.entities()[row]);
+            }
+        }
+    }
+
+    // Every archetype in creation order, a flat array to walk. Only ever appended to, so queries
+    // can pick up new archetypes by remembering how far they've looked. Empty ones stay in it.
+    const std::vector<Archetype*>& getArchetypeList() const
+    {
+        return archetypeList;
+    }
+
+    // Changes whenever some archetype became empty or stopped being empty, or gained or lost a chunk
+    uint64_t getOccupancyVersion() const { return occupancyVersion; }
+
+    // Give back memory a large despawn left behind: empty chunks go back to the OS through
+    // ChunkAllocator::trim() and sparse sets drop their spare capacity. Returns the bytes released.
+    // Between frames only, like any structural change.
+    size_t compact()
+    {
+        size_t released = 0;
+        for (SparseSet* set : activeSparseSets) {
+            released += set->shrinkToFit();
+        }
+        return released + chunkAllocator->trim();
+    }
+
+    // World-owned query for Components, built on first use and kept up to date from then on.
+    // Safe to call from systems running side by side, the first call builds it under a lock
+    template<typename... Components>
+    Query<Components...>& query();
+
+    // Live entities
+    size_t getEntityCount() const { return entityRecords.size() - freeList.size(); }
+
+    // One entry per archetype that holds chunks or lost rows this frame, in creation order
+    std::vector<ArchetypeStats> getArchetypeStats() const
+    {
+        std::vector<ArchetypeStats> stats;
+        for (const Archetype* arch : archetypeList)
+        {
+            if (arch->getChunks().empty() && arch->getMovesOut() == 0) continue;
+            ArchetypeStats entry;
+            for (int compID : arch->getComponentIDs()) {
+                if (!entry.signature.empty()) entry.signature += '|';
+                entry.signature += ComponentRegistry::getName(compID);
+            }
+            if (entry.signature.empty()) entry.signature = "<empty>";
+
+            const size_t rows = arch->getChunks().size() * arch->getChunkCapacity();
+            entry.entityCount    = arch->getEntityCount();
+            entry.chunkCount     = arch->getChunks().size();
+            entry.chunkCapacity  = arch->getChunkCapacity();
+            entry.slackRows      = rows - entry.entityCount;
+            entry.allocatedBytes = entry.chunkCount * arch->getChunkBytes();
+            entry.movesIn        = arch->getMovesIn();
+            entry.movesOut       = arch->getMovesOut();
+            for (const auto& comp : arch->components) {
+                entry.columns.push_back({ ComponentRegistry::getName(comp.compID), comp.componentSize,
+                                          comp.componentSize * entry.entityCount, comp.componentSize * rows });
+            }
+            stats.push_back(std::move(entry));
+        }
+        return stats;
+    }
+
+    std::vector<SparseSetStats> getSparseSetStats() const
+    {
+        std::vector<SparseSetStats> stats;
+        for (const SparseSet* set : activeSparseSets) {
+            const size_t size = ComponentRegistry::getSize(set->getComponentID());
+            stats.push_back({ ComponentRegistry::getName(set->getComponentID()), set->size(), set->size() * (size + sizeof(Entity)) });
+        }
+        return stats;
+    }
+
+    // Start counting structural moves for a new frame
+    void resetFrameStats()
+    {
+        for (Archetype* arch : archetypeList) arch->resetMoveCounts();
+    }
+
+    // Where e's row lives. False if e is dead
+    bool locate(Entity e, Archetype*& archetype, EntityLocation& location) const
+    {
+        if (!isAlive(e)) return false;
+        archetype = entityRecords[e.id].archetype;
+        location  = entityRecords[e.id].location;
+        return true;
+    }
+
+    // Storage of a StorageKind::Sparse component, created on first use
+    SparseSet& getSparseSet(int compID)
+    {
+        auto& set = sparseSets[compID];
+        if (!set) {
+            set = std::make_unique<SparseSet>(compID, ComponentRegistry::getSize(compID), ComponentRegistry::getOps(compID));
+            activeSparseSets.push_back(set.get());
+        }
+        return *set;
+    }
+
+    // Tick that writes are stamped with right now
+    uint32_t getChangeTick() const { return changeTick; }
+
+    // Close the current tick and return it. Anything written after this call is newer than the
+    // returned value, so a consumer keeps it and asks for "changed since" next time round:
+    //     query.forEachChunkChangedSince<Transform>(lastTick, ...);
+    //     lastTick = world.advanceChangeTick();
+    // Not while systems are running.
+    uint32_t advanceChangeTick() { return changeTick++; }
+
+    // The calling thread's command buffer. Safe to record into from inside
+    // forEachChunkParallel and scheduled systems, every JobSystem thread has its own.
+    CommandBuffer& commands();
+
+    // Apply everything recorded in the command buffers. Must not run while anything iterates the world.
+    void flushCommands();
+
+    // The entity a handle from commands().createEntity() became at the last flushCommands().
+    // Any other handle comes back as it is.
+    Entity resolve(Entity e) const;
+
+    // What the calling thread's commands get tagged with. flushCommands() applies them sorted by it,
+    // so the outcome doesn't depend on which thread ran what. SystemScheduler sets the system,
+    // the parallel queries the phase and job.
+    CommandSource getCommandSource() const;
+    void setCommandSource(const CommandSource& source);
+
+private:
+    friend class CommandBuffer;
+    friend class Snapshot;
+    friend class Rollback;
+
+    // One slot per entity ID ever handed out
+    struct EntityRecord {
+        Archetype* archetype = nullptr; // nullptr while the slot is free
+        EntityLocation location;
+        uint32_t generation = 0;
+    };
+
+    EntityRecord* findRecord(Entity e)
+    {
+        return isAlive(e) ? &entityRecords[e.id] : nullptr;
+    }
+
+    struct HookSlot {
+        HookID id;
+        std::function<void(Entity)> hook;
+    };
+
+    // hook(e, value) behind a hook(e), the value read whatever T's storage
+    template<typename T, typename Hook>
+    std::function<void(Entity)> typedHook(Hook hook)
+    {
+        using Value = std::remove_const_t<T>;
+        return [this, hook = std::move(hook)](Entity e) mutable {
+            if constexpr (detail::HasSplitFields<Value>) {
+                if (auto value = getComponentValue<Value>(e)) hook(e, *value);
+            } else if (const Value* value = getComponent<const Value>(e)) {
+                hook(e, *value);
+            }
+        };
+    }
+
+    void runHooks(HookEvent event, int compID, std::span<const Entity> entities)
+    {
+        for (HookSlot& slot : hooks[size_t(event)][compID]) {
+            for (Entity e : entities) slot.hook(e);
+        }
+    }
+
+    // Run the event's hooks of every component in comps, for each of entities
+    void notify(HookEvent event, const Signature& comps, std::span<const Entity> entities)
+    {
+        const Signature hooked = comps & hookedComponents[size_t(event)];
+        if (hooked.none() || entities.empty()) return;
+        for (int compID = 0; compID < MAX_COMPONENTS; ++compID) {
+            if (hooked.test(compID)) runHooks(event, compID, entities);
+        }
+    }
+
+    void notifyOne(HookEvent event, int compID, Entity e)
+    {
+        if (hookedComponents[size_t(event)].test(compID)) runHooks(event, compID, { &e, 1 });
+    }
+
+    // Same for every entity that has a hooked component, e.g. after a whole world got loaded
+    void notifyAll(HookEvent event)
+    {
+        const Signature hooked = hookedComponents[size_t(event)];
+        for (int compID = 0; compID < MAX_COMPONENTS; ++compID) {
+            if (!hooked.test(compID)) continue;
+            forEachWith(compID, [&](Entity e) { runHooks(event, compID, { &e, 1 }); });
+        }
+    }
+
+    // Every component e has, sparse ones included
+    Signature componentsOf(Entity e) const
+    {
+        Signature sig = entityRecords[e.id].archetype->getSignature();
+        for (const SparseSet* set : activeSparseSets) {
+            if (set->contains(e)) sig.set(set->getComponentID());
+        }
+        return sig;
+    }
+
+    // Pop a free slot or grow the table
+    Entity allocateEntity()
+    {
+        uint32_t index;
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(entityRecords.size());
+            entityRecords.emplace_back();
+        }
+        return Entity{ index, entityRecords[index].generation };
+    }
+
+    // Allocate count slots and append them to arch in one block. Handles go to out,
+    // returns where the first row landed.
+    EntityLocation createEntitiesIn(Archetype* arch, size_t count, std::vector<Entity>& out)
+    {
+        return createEntitiesIn(arch, count, out, [arch](Archetype::Chunk& chunk, size_t row, size_t n, size_t) {
+            for (auto& comp : arch->components) {
+                Archetype::constructRows(comp, chunk.column(comp), arch->getChunkCapacity(), row, n);
+            }
+        });
+    }
+
+    // Same, with the rows constructed by fill (see Archetype::appendRows)
+    template<typename Fill>
+    EntityLocation createEntitiesIn(Archetype* arch, size_t count, std::vector<Entity>& out, Fill&& fill)
+    {
+        out.reserve(out.size() + count);
+        const size_t firstOut = out.size();
+        const size_t reused = std::min(count, freeList.size());
+        for (size_t i = 0; i < reused; ++i) {
+            uint32_t index = freeList[freeList.size() - 1 - i];
+            out.push_back(Entity{ index, entityRecords[index].generation });
+        }
+        freeList.resize(freeList.size() - reused);
+
+        const size_t firstNew = entityRecords.size();
+        entityRecords.resize(firstNew + (count - reused));
+        for (size_t id = firstNew; id < entityRecords.size(); ++id) {
+            out.push_back(Entity{ static_cast<uint32_t>(id), 0 });
+        }
+
+        EntityLocation first = arch->appendRows(out.data() + firstOut, count, fill);
+        for (size_t i = 0; i < count; ++i) {
+            EntityRecord& record = entityRecords[out[firstOut + i].id];
+            record.archetype = arch;
+            record.location  = arch->advance(first, i);
+        }
+        return first;
+    }
+
+    // Signature of the components that live in archetype columns, sparse ones are left out
+    static Signature tableSignature(const std::vector<int>& compIDs)
+    {
+        Signature sig;
+        for (int id : compIDs) {
+            if (!ComponentRegistry::isSparse(id)) sig.set(id);
+        }
+        return sig;
+    }
+
+    // Default-construct the sparse components among compIDs for every entity
+    void emplaceSparse(const std::vector<int>& compIDs, std::span<const Entity> entities)
+    {
+        for (int id : compIDs) {
+            if (!ComponentRegistry::isSparse(id)) continue;
+            SparseSet& set = getSparseSet(id);
+            for (Entity e : entities) set.emplace(e);
+        }
+    }
+
+    // Put T's value in key if T is a Shared component
+    template<typename T>
+    void keyShared(SharedKey& key, const T& value)
+    {
+        const int compID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isShared(compID)) {
+            key[compID] = internShared(compID, &value);
+        }
+    }
+
+    // Copy value into prefab. Trivial table columns get a chunk's worth of copies to memcpy rows from,
+    // laid out like the column (so field by field for split ones)
+    template<typename T>
+    void capturePrefabValue(Prefab& prefab, const T& value)
+    {
+        static_assert(std::is_copy_constructible_v<T>, "Prefab components have to be copyable");
+        const int compID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isShared(compID)) {
+            return; // Kept by the archetype
+        }
+        Prefab::Value* slot;
+        if (ComponentRegistry::isSparse(compID)) {
+            prefab.sparse.push_back({ { compID, ComponentRegistry::getSize(compID), 0, ComponentRegistry::getOps(compID) }, nullptr, 0 });
+            slot = &prefab.sparse.back();
+        } else {
+            slot = &prefab.columns[prefab.archetype->compMap[compID]];
+            Archetype::destroyValues(slot->column, slot->data.get(), slot->rows); // Same type passed twice, last wins
+        }
+        const Archetype::ComponentData& comp = slot->column;
+        slot->rows = comp.ops.trivialRelocate && !ComponentRegistry::isSparse(compID) ? prefab.archetype->getChunkCapacity() : 1;
+        slot->data = std::make_unique<uint8_t[]>(std::max<size_t>(slot->rows * comp.componentSize, 1));
+        Archetype::fillRows(comp, slot->data.get(), slot->rows, 0, reinterpret_cast<const uint8_t*>(&value), slot->rows);
+    }
+
+    // Body of both instantiate()s. When overrideID isn't -1, overrides holds count values of that component
+    // that replace the prefab's.
+    std::vector<Entity> instantiateRows(const Prefab& prefab, size_t count, int overrideID, const uint8_t* overrides)
+    {
+        if (prefab.world != this) {
+            throw std::runtime_error("Prefab belongs to another World!");
+        }
+        if (overrideID >= 0 && !prefab.getValue(overrideID)) {
+            throw std::runtime_error("instantiate override isn't one of the prefab's components!");
+        }
+        if (overrideID >= 0 && ComponentRegistry::isShared(overrideID)) {
+            throw std::runtime_error("Shared components can't be overridden per instance, make another prefab!");
+        }
+
+        Archetype* arch = prefab.archetype;
+        std::vector<Entity> created;
+        createEntitiesIn(arch, count, created, [&](Archetype::Chunk& chunk, size_t row, size_t n, size_t placed) {
+            for (const Prefab::Value& v : prefab.columns)
+            {
+                const Archetype::ComponentData& comp = v.column;
+                uint8_t* column = chunk.column(comp);
+                const size_t capacity = arch->getChunkCapacity();
+                if (comp.compID == overrideID) {
+                    Archetype::scatterRows(comp, column, capacity, row, overrides + placed * comp.componentSize, n);
+                } else if (v.rows > 1) {
+                    Archetype::copyRows(comp, column, capacity, row, v.data.get(), v.rows, 0, n); // n never exceeds a chunk
+                } else {
+                    Archetype::fillRows(comp, column, capacity, row, v.data.get(), n);
+                }
+            }
+        });
+
+        for (const Prefab::Value& v : prefab.sparse)
+        {
+            const Archetype::ComponentData& comp = v.column;
+            SparseSet& set = getSparseSet(comp.compID);
+            for (size_t i = 0; i < created.size(); ++i)
+            {
+                uint8_t* value = static_cast<uint8_t*>(set.emplace(created[i]));
+                const uint8_t* src = comp.compID == overrideID ? overrides + i * comp.componentSize : v.data.get();
+                Archetype::destroyValues(comp, value, 1);
+                Archetype::copyValues(comp, value, src, 1);
+            }
+        }
+
+        Signature added = arch->getSignature();
+        for (const Prefab::Value& v : prefab.sparse) added.set(v.column.compID);
+        notify(HookEvent::Add, added, created);
+        return created;
+    }
+
+    // Initial value of T for freshly created entities, column-wise or into its sparse set.
+    // Shared values went into the archetype's key already
+    template<typename T>
+    void fillComponent(Archetype* arch, EntityLocation first, const std::vector<Entity>& created, const T& value)
+    {
+        const int compID = ComponentRegistry::getID<T>();
+        if (ComponentRegistry::isSparse(compID)) {
+            SparseSet& set = getSparseSet(compID);
+            for (Entity e : created) *static_cast<T*>(set.emplace(e)) = value;
+        } else if (!ComponentRegistry::isShared(compID)) {
+            fillColumn(arch, first, created.size(), value);
+        }
+    }
+
+    // Assign value to count consecutive rows of T's column, starting at first
+    template<typename T>
+    void fillColumn(Archetype* arch, EntityLocation first, size_t count, const T& value)
+    {
+        if constexpr (std::is_empty_v<T>) {
+            return; // Zero-size column, nothing to write
+        }
+        const int compID = ComponentRegistry::getID<T>();
+        const auto& comp = arch->components[arch->compMap[compID]];
+        size_t row = first.row;
+        for (size_t chunk = first.chunk; count > 0; ++chunk, row = 0)
+        {
+            size_t n = std::min(count, arch->getChunkCapacity() - row);
+            if (comp.split) {
+                // Trivially copyable, so copying over the default is assigning
+                Archetype::fillRows(comp, arch->getChunks()[chunk].column(comp), arch->getChunkCapacity(), row,
+                                    reinterpret_cast<const uint8_t*>(&value), n);
+            } else {
+                T* column = reinterpret_cast<T*>(arch->getComponentData({ static_cast<uint32_t>(chunk), static_cast<uint32_t>(row) }, compID));
+                std::fill_n(column, n, value);
+            }
+            count -= n;
+        }
+    }
+
+    // Assign value to the compID of the row at loc, which has one
+    template<typename T>
+    static void assignComponent(Archetype* arch, const EntityLocation& loc, int compID, const T& value)
+    {
+        if (T* ptr = reinterpret_cast<T*>(arch->getComponentData(loc, compID))) {
+            *ptr = value;
+        } else if (ComponentRegistry::isSplit(compID)) {
+            arch->writeRow(loc, compID, &value);
+        }
+    }
+
+    // Slot is empty now: bump the generation (invalidates every handle still pointing at it) and free it
+    void releaseSlot(uint32_t id)
+    {
+        EntityRecord& record = entityRecords[id];
+        record.archetype = nullptr;
+        ++record.generation;
+        freeList.push_back(id);
+    }
+
+    // Swap-and-pop a row and patch up whichever entity got moved into it
+    void removeRow(Archetype* arch, const EntityLocation& loc)
+    {
+        Entity moved;
+        if (arch->removeEntity(loc, moved)) {
+            entityRecords[moved.id].location = loc;
+        }
+    }
+
+    // Create/fetch archetype for a component bitmask, and for the values of its Shared components.
+    // Entries of key for anything that isn't a Shared component of sig are ignored
+    Archetype* getOrCreateArchetype(const Signature& sig, const SharedKey& key = SharedKey{})
+    {
+        SharedKey sharedKey{};
+        for (int cID = 0; cID < MAX_COMPONENTS; ++cID) {
+            if (sig.test(cID) && ComponentRegistry::isShared(cID)) sharedKey[cID] = key[cID];
+        }
+        auto [first, last] = archetypeLookup.equal_range(sig);
+        for (auto it = first; it != last; ++it) {
+            if (it->second->getSharedKey() == sharedKey) return it->second;
+        }
+
+        // New archetype
+        auto newArch = std::make_unique<Archetype>(sig);
+        for (int cID : newArch->getComponentIDs()) {
+            if (ComponentRegistry::isShared(cID)) {
+                newArch->setSharedValue(cID, sharedKey[cID], sharedValue(cID, sharedKey[cID]));
+                continue;
+            }
+            const ComponentInfo& info = ComponentRegistry::getInfo(cID);
+            newArch->initializeComponentStorage(cID, info.size, info.ops, info.fieldCount > 0 ? &info : nullptr);
+        }
+        newArch->buildChunkLayout();
+        newArch->setChangeTickSource(&changeTick);
+        newArch->setAllocator(chunkAllocator);
+        newArch->setOccupancyCounter(&occupancyVersion);
+
+        Archetype* ptr = newArch.get();
+        archetypes.push_back(std::move(newArch));
+        archetypeList.push_back(ptr);
+        archetypeLookup.emplace(sig, ptr);
+        return ptr;
+    }
+
+    // Follow (or lazily create) the "add compID" edge of an archetype. A Shared compID comes in
+    // with its default value, the other shared values stay what they were
+    Archetype* getAddTarget(Archetype* arch, int compID)
+    {
+        Archetype* target = arch->addEdges[compID];
+        if (!target) {
+            Signature sig = arch->getSignature();
+            sig.set(compID);
+            target = getOrCreateArchetype(sig, arch->getSharedKey());
+            arch->addEdges[compID]      = target;
+            target->removeEdges[compID] = arch;
+        }
+        return target;
+    }
+
+    // Follow (or lazily create) the "remove compID" edge of an archetype
+    Archetype* getRemoveTarget(Archetype* arch, int compID)
+    {
+        Archetype* target = arch->removeEdges[compID];
+        if (!target) {
+            Signature sig = arch->getSignature();
+            sig.reset(compID);
+            target = getOrCreateArchetype(sig, arch->getSharedKey());
+            arch->removeEdges[compID] = target;
+            // Adding compID back only lands here if it's a table one or had the default value
+            if (!ComponentRegistry::isShared(compID) || arch->getSharedKey()[compID] == 0) {
+                target->addEdges[compID] = arch;
+            }
+        }
+        return target;
+    }
+
+    // Where an entity of arch goes when its Shared compID is set to value. Not cached,
+    // there's an edge per value
+    Archetype* getSharedTarget(Archetype* arch, int compID, const void* value)
+    {
+        SharedKey key = arch->getSharedKey();
+        key[compID] = internShared(compID, value);
+        if (arch->hasComponent(compID) && key[compID] == arch->getSharedKey()[compID]) {
+            return arch;
+        }
+        Signature sig = arch->getSignature();
+        sig.set(compID);
+        return getOrCreateArchetype(sig, key);
+    }
+
+    // Index of the interned copy of a Shared component's value, equal bytes get the same one
+    uint32_t internShared(int compID, const void* value)
+    {
+        SharedValues& table = sharedTable(compID);
+        const size_t size = ComponentRegistry::getSize(compID);
+        std::string bytes(static_cast<const char*>(value), size);
+        auto [it, inserted] = table.index.emplace(std::move(bytes), static_cast<uint32_t>(table.values.size()));
+        if (inserted) {
+            auto copy = std::make_unique<uint8_t[]>(std::max<size_t>(size, 1));
+            std::memcpy(copy.get(), value, size);
+            table.values.push_back(std::move(copy));
+        }
+        return it->second;
+    }
+
+    const uint8_t* sharedValue(int compID, uint32_t index)
+    {
+        return sharedTable(compID).values[index].get();
+    }
+
+    // Interned values of a Shared component, index 0 (the default-constructed value) made on first use
+    struct SharedValues {
+        std::vector<std::unique_ptr<uint8_t[]>> values;
+        std::unordered_map<std::string, uint32_t> index; // Value bytes -> index in values
+    };
+
+    SharedValues& sharedTable(int compID)
+    {
+        SharedValues& table = sharedValues[compID];
+        if (table.values.empty()) {
+            const size_t size = ComponentRegistry::getSize(compID);
+            auto value = std::make_unique<uint8_t[]>(std::max<size_t>(size, 1));
+            Archetype::constructValues({ compID, size, 0, ComponentRegistry::getOps(compID) }, value.get(), 1);
+            table.index.emplace(std::string(reinterpret_cast<const char*>(value.get()), size), 0);
+            table.values.push_back(std::move(value));
+        }
+        return table;
+    }
+
+    // Moves an entity between two archetypes, relocating shared component data
+    void moveEntityToArchetype(Entity e, EntityRecord& record, Archetype* newArch)
+    {
+        Archetype* oldArch = record.archetype;
+        if (oldArch == newArch) return;
+
+        // 1) Add to new arch (different buffers, so old pointers stay valid)
+        EntityLocation oldLoc = record.location;
+        EntityLocation newLoc = newArch->allocateRow(e);
+
+        // 2) Move overlapping components straight across, default-construct the new ones
+        const Archetype::Chunk& newChunk = newArch->getChunks()[newLoc.chunk];
+        const Archetype::Chunk& oldChunk = oldArch->getChunks()[oldLoc.chunk];
+        for (auto& comp : newArch->components)
+        {
+            const int oldColumn = oldArch->compMap[comp.compID];
+            if (oldColumn >= 0) {
+                Archetype::relocateRows(comp, newChunk.column(comp), newArch->getChunkCapacity(), newLoc.row,
+                                        oldChunk.column(oldArch->components[oldColumn]), oldArch->getChunkCapacity(), oldLoc.row, 1);
+            } else {
+                Archetype::constructRows(comp, newChunk.column(comp), newArch->getChunkCapacity(), newLoc.row, 1);
+            }
+        }
+        // ...and whatever the new archetype doesn't have dies with the old row
+        for (auto& comp : oldArch->components)
+        {
+            if (!newArch->hasComponent(comp.compID)) {
+                Archetype::destroyValues(comp, oldArch->getComponentData(oldLoc, comp.compID), 1);
+            }
+        }
+
+        // 3) Remove the now vacated row from old arch
+        Entity moved;
+        if (oldArch->removeVacatedRow(oldLoc, moved)) {
+            entityRecords[moved.id].location = oldLoc;
+        }
+
+        // 4) Update the record
+        record.archetype = newArch;
+        record.location  = newLoc;
+        oldArch->countMove(false);
+        newArch->countMove(true);
+    }
+
+    // Declared first so it goes last, after every archetype is done with it
+    std::unique_ptr<ChunkAllocator> ownedAllocator;
+    ChunkAllocator* chunkAllocator = nullptr;
+
+    std::vector<std::unique_ptr<Archetype>> archetypes; // Creation order
+    std::vector<Archetype*> archetypeList;              // Same, as the plain pointers everyone walks
+    std::unordered_multimap<Signature, Archetype*> archetypeLookup; // Several per signature when they differ in shared values
+    std::array<SharedValues, MAX_COMPONENTS> sharedValues;
+    uint64_t occupancyVersion = 0; // See getOccupancyVersion()
+    std::vector<EntityRecord> entityRecords;
+    std::vector<uint32_t> freeList;
+    std::vector<std::unique_ptr<QueryBase>> cachedQueries; // Owned here, in creation order
+    std::array<std::atomic<QueryBase*>, MAX_QUERY_TYPES> querySlots{}; // Indexed by detail::querySlot
+    std::mutex queryMutex; // Guards creating queries, lookups don't take it
+    std::vector<std::unique_ptr<CommandBuffer>> commandBuffers; // One per JobSystem thread
+    uint32_t changeTick = 1; // 0 is "before anything happened"
+    std::array<std::unique_ptr<SparseSet>, MAX_COMPONENTS> sparseSets; // Indexed by component ID
+    std::vector<SparseSet*> activeSparseSets; // The non-null ones, for destroy
+    std::array<std::array<std::vector<HookSlot>, MAX_COMPONENTS>, 3> hooks; // By HookEvent, then component ID
+    std::array<Signature, 3> hookedComponents; // Components with at least one hook, by HookEvent
+    HookID nextHookID = 1;
+    uint32_t publishedTick = 0; // Tick the last publishChanges() closed
+};
+
+// ============ Detail namespace for type expansion trick ============
+namespace detail
+{
+    enum class TermKind : uint8_t { Required, Optional, With, Without, Changed, Shared, Split };
+
+    // What a query term asks for. A plain component type is Required
+    template<typename T>
+    struct QueryTerm {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::Required;
+    };
+    template<typename T>
+    struct QueryTerm<Optional<T>> {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::Optional;
+    };
+    template<typename T>
+    struct QueryTerm<With<T>> {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::With;
+    };
+    template<typename T>
+    struct QueryTerm<Without<T>> {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::Without;
+    };
+    template<typename T>
+    struct QueryTerm<Changed<T>> {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::Changed;
+    };
+    template<typename T>
+    struct QueryTerm<Shared<T>> {
+        using Component = const std::remove_const_t<T>; // Read-only, the value is the archetype's
+        static constexpr TermKind kind = TermKind::Shared;
+    };
+    template<typename T>
+    struct QueryTerm<Split<T>> {
+        using Component = T;
+        static constexpr TermKind kind = TermKind::Split;
+    };
+
+    // Terms that get an argument in the callback, the rest only filter
+    template<typename Term>
+    constexpr bool isPassed = QueryTerm<Term>::kind == TermKind::Required || QueryTerm<Term>::kind == TermKind::Optional
+                           || QueryTerm<Term>::kind == TermKind::Shared || QueryTerm<Term>::kind == TermKind::Split;
+
+    // Callback argument of a passed term: a pointer to the column, or the arrays of a split one
+    template<typename Term>
+    using TermPointer = std::conditional_t<QueryTerm<Term>::kind == TermKind::Split,
+        SplitColumn<typename QueryTerm<Term>::Component>, typename QueryTerm<Term>::Component*>;
+
+    template<size_t I, typename... Terms>
+    using TermAt = std::tuple_element_t<I, std::tuple<Terms...>>;
+
+    // Positions of the passed terms among Terms
+    template<typename... Terms>
+    constexpr auto passedIndices()
+    {
+        constexpr std::array<bool, sizeof...(Terms)> passed{ isPassed<Terms>... };
+        std::array<size_t, (size_t{ isPassed<Terms> } + ... + 0)> indices{};
+        size_t n = 0;
+        for (size_t i = 0; i < passed.size(); ++i) {
+            if (passed[i]) indices[n++] = i;
+        }
+        return indices;
+    }
+
+    // Column offset of a term the archetype doesn't have (Optional, Without, Shared)
+    constexpr size_t NO_COLUMN = SIZE_MAX;
+
+    // Callback argument for Term in the chunk starting at base: its column, or the one value of a Shared term
+    template<typename Term>
+    TermPointer<Term> termPointer(uint8_t* base, size_t offset, const uint8_t* shared, size_t capacity)
+    {
+        if constexpr (QueryTerm<Term>::kind == TermKind::Shared) {
+            return reinterpret_cast<TermPointer<Term>>(shared);
+        } else if constexpr (QueryTerm<Term>::kind == TermKind::Split) {
+            return TermPointer<Term>(base + offset, capacity, 0);
+        } else {
+            return offset == NO_COLUMN ? nullptr : reinterpret_cast<TermPointer<Term>>(base + offset);
+        }
+    }
+
+    // Same for one entity, pointer being what Query::resolveRow found: the column start for a split term
+    template<typename Term>
+    TermPointer<Term> rowPointer(void* pointer, size_t capacity, size_t row)
+    {
+        if constexpr (QueryTerm<Term>::kind == TermKind::Split) {
+            return TermPointer<Term>(static_cast<uint8_t*>(pointer), capacity, row);
+        } else {
+            return static_cast<TermPointer<Term>>(pointer);
+        }
+    }
+
+    // We define a helper that, given the user callback, the arrays, and the entity list,
+    // calls: callback(entities, typedPtr1, typedPtr2, ..., count)
+    // Only passed terms get an argument, and an Optional one is nullptr where the archetype lacks it.
+    template <typename... Terms, typename ChunkCallback, size_t... Indices>
+    void invokeChunkCallbackImpl(
+        ChunkCallback& cb,
+        const Archetype::Chunk& chunk,
+        const std::array<size_t, sizeof...(Terms)>& offsets,
+        const std::array<const uint8_t*, sizeof...(Terms)>& shared,
+        size_t capacity,
+        std::index_sequence<Indices...>)
+    {
+        constexpr auto passed = passedIndices<Terms...>();
+        // We'll turn each column offset into the corresponding type pointer.
+        // So offsets[0] => Components0 pointer, offsets[1] => Components1 pointer, etc.
+        uint8_t* base = chunk.memory;
+        cb(
+            chunk.entities(),
+            termPointer<TermAt<passed[Indices], Terms...>>(base, offsets[passed[Indices]], shared[passed[Indices]], capacity)...,
+            chunk.count
+        );
+    }
+
+    // One entity found outside the chunk walk, every component pointer already resolved:
+    // callback(entity, ptr1, ptr2, ..., 1)
+    template <typename... Terms, typename ChunkCallback, size_t... Indices>
+    void invokeRowCallbackImpl(
+        ChunkCallback& cb,
+        const Entity* entity,
+        const std::array<void*, sizeof...(Terms)>& pointers,
+        size_t capacity,
+        size_t row,
+        std::index_sequence<Indices...>)
+    {
+        constexpr auto passed = passedIndices<Terms...>();
+        cb(entity, rowPointer<TermAt<passed[Indices], Terms...>>(pointers[passed[Indices]], capacity, row)..., size_t{ 1 });
+    }
+
+    template <typename... Terms, typename ChunkCallback>
+    void invokeRowCallback(
+        ChunkCallback& cb,
+        const Entity* entity,
+        const std::array<void*, sizeof...(Terms)>& pointers,
+        size_t capacity,
+        size_t row)
+    {
+        invokeRowCallbackImpl<Terms...>(cb, entity, pointers, capacity, row, std::make_index_sequence<passedIndices<Terms...>().size()>{});
+    }
+
+    template <typename... Terms, typename ChunkCallback>
+    void invokeChunkCallback(
+        ChunkCallback& cb,
+        const Archetype::Chunk& chunk,
+        const std::array<size_t, sizeof...(Terms)>& offsets,
+        const std::array<const uint8_t*, sizeof...(Terms)>& shared,
+        size_t capacity
+    )
+    {
+        // Generate a compile-time index sequence for the number of passed terms
+        invokeChunkCallbackImpl<Terms...>(
+            cb,
+            chunk,
+            offsets,
+            shared,
+            capacity,
+            std::make_index_sequence<passedIndices<Terms...>().size()>{}
+        );
+    }
+
+    // Each distinct Query<Components...> type gets a slot in World's query cache
+    inline size_t nextQuerySlot()
+    {
+        static std::atomic<size_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename... Components>
+    size_t querySlot()
+    {
+        static const size_t slot = nextQuerySlot();
+        return slot;
+    }
+
+    // Position of the term for T in Terms, ignoring const and the term kind. sizeof...(Terms) if it isn't there
+    template<typename T, typename... Terms>
+    constexpr size_t indexOf()
+    {
+        constexpr std::array<bool, sizeof...(Terms)> same{
+            std::is_same_v<std::remove_const_t<T>, std::remove_const_t<typename QueryTerm<Terms>::Component>>... };
+        for (size_t i = 0; i < same.size(); ++i) {
+            if (same[i]) return i;
+        }
+        return sizeof...(Terms);
+    }
+} // namespace detail
+
+/*
+    ===================
+    QUERY
+    ===================
+    - Built once for a set of components, remembers which archetypes match
+      and where each column sits inside their chunks.
+    - Only looks at archetypes created since the last iteration, so
+      iterating allocates nothing unless the world grew a new archetype.
+    - Walks a flat copy of the matches that currently have entities, rebuilt only
+      when an archetype gains or loses a chunk, so dead archetypes cost nothing.
+    - Iterating stamps the chunk's change tick for every non-const component,
+      and the ...ChangedSince variants skip chunks whose column wasn't written.
+    - Besides plain components the list takes filter terms, e.g.
+          world.query<Transform, Optional<const Velocity>, Without<Car>, Changed<Mesh>>()
+      Optional<T> hands out a T* that is nullptr for chunks without T; With<T>, Without<T> and
+      Changed<T> only filter and get no callback argument. Table terms are decided per archetype
+      (With/Without) or per chunk (Changed, against the tick given to since()), never per entity.
+    - Sparse components have no column to hand out. A query with one walks that
+      component's SparseSet instead and calls the callback once per matching entity
+      with count == 1, so callbacks work unchanged with either storage. The same goes
+      for a sparse Optional/Without term, which has to be checked entity by entity.
+    - StorageKind::Shared components have no column either, they're asked for with
+      Shared<T> and the callback gets a const T* to the value every row of the chunk has.
+    - Field-split components (SplitFields) are asked for with Split<T>, and the callback
+      gets a SplitColumn<T> with one array per field instead of a T*.
+*/
+template<typename... Components>
+class Query : public QueryBase
+{
+public:
+    explicit Query(World& world)
+        : world(&world)
+        , componentIDs{ ComponentRegistry::getID<typename detail::QueryTerm<Components>::Component>()... }
+    {
+        sparseSets.fill(nullptr);
+        for (size_t c = 0; c < componentIDs.size(); ++c)
+        {
+            const bool sparse = ComponentRegistry::isSparse(componentIDs[c]);
+            if (sparse) {
+                sparseSets[c] = &world.getSparseSet(componentIDs[c]);
+            }
+            const bool shared = ComponentRegistry::isShared(componentIDs[c]);
+            const bool split  = ComponentRegistry::isSplit(componentIDs[c]);
+            splitTerms[c] = split;
+            const bool filter = kinds[c] == detail::TermKind::With || kinds[c] == detail::TermKind::Without;
+            if (shared != (kinds[c] == detail::TermKind::Shared) && !filter) {
+                throw std::runtime_error("Query term for " + ComponentRegistry::getName(componentIDs[c])
+                    + (shared ? " has to be Shared<T>, it's a shared component!" : " can't be Shared<T>, it isn't a shared component!"));
+            }
+            if (split != (kinds[c] == detail::TermKind::Split) && !filter && kinds[c] != detail::TermKind::Changed) {
+                throw std::runtime_error("Query term for " + ComponentRegistry::getName(componentIDs[c])
+                    + (split ? " has to be Split<T>, it's a split component!" : " can't be Split<T>, it isn't a split component!"));
+            }
+            switch (kinds[c])
+            {
+            case detail::TermKind::Shared:
+            case detail::TermKind::Split:
+                requiredMask.set(componentIDs[c]);
+                break;
+            case detail::TermKind::Required:
+            case detail::TermKind::With:
+            case detail::TermKind::Changed:
+                if (!sparse) requiredMask.set(componentIDs[c]);
+                else if (driver == NO_DRIVER) driver = c;
+                break;
+            case detail::TermKind::Without:
+                if (!sparse) excludedMask.set(componentIDs[c]);
+                else perEntity = true;
+                break;
+            case detail::TermKind::Optional:
+                if (sparse) perEntity = true;
+                break;
+            }
+        }
+        perEntity = perEntity || driver != NO_DRIVER;
+    }
+
+    // The query with a threshold for its Changed<T> terms: only chunks whose T column was written
+    // after tick pass. Plain iteration uses 0, i.e. everything ever written. A view by value, so
+    // systems sharing the cached query don't step on each other's threshold:
+    //     world.query<Mesh, Changed<Transform>>().since(lastTick).forEachChunk(...);
+    class Since
+    {
+    public:
+        Since(Query& query, uint32_t tick) : query(&query), tick(tick) {}
+
+        template<typename ChunkCallback>
+        void forEachChunk(ChunkCallback&& callback) { query->walkChunks(tick, callback); }
+
+        template<typename ChunkCallback>
+        void forEachChunkParallel(ChunkCallback&& callback) { query->walkChunksParallel(tick, callback); }
+
+        template<typename Result, typename ChunkCallback, typename MergeCallback>
+        Result reduceChunksParallel(const Result& init, ChunkCallback&& callback, MergeCallback&& merge)
+        {
+            return query->reduceChunks(tick, init, callback, merge);
+        }
+
+        size_t count() { return query->countRows(tick); }
+
+    private:
+        Query* query;
+        uint32_t tick;
+    };
+
+    Since since(uint32_t tick)
+    {
+        static_assert(hasChangedTerms, "since() is the threshold for Changed<T> terms, the query has none");
+        return Since(*this, tick);
+    }
+
+    // callback(const Entity* ents, Components*... arrays, size_t count), once per non-empty chunk
+    template<typename ChunkCallback>
+    void forEachChunk(ChunkCallback&& callback)
+    {
+        walkChunks(0, callback);
+    }
+
+    // Same as forEachChunk, but only the chunks where T's column was written after sinceTick
+    // (see World::advanceChangeTick). The check is per chunk, before any component data is touched.
+    template<typename T, typename ChunkCallback>
+    void forEachChunkChangedSince(uint32_t sinceTick, ChunkCallback&& callback)
+    {
+        constexpr size_t watched = detail::indexOf<T, Components...>();
+        static_assert(watched < sizeof...(Components), "Changed component has to be part of the query");
+
+        if (isSparseDriven()) {
+            forEachRow([&](SparseRow& row, size_t)
+            {
+                if (!changedSince(row, watched, sinceTick)) return;
+                markWrites(row);
+                invokeRow(callback, row);
+            }, false, 0);
+            return;
+        }
+        refresh();
+        for (const Match& match : active)
+        {
+            for (const auto& chunk : match.archetype->getChunks())
+            {
+                if (!changedSince(match, chunk, watched, sinceTick) || !passesChanged(match, chunk, 0)) continue;
+                markWrites(match, chunk);
+                invokeChunk(callback, match, chunk);
+            }
+        }
+    }
+
+    // Same as forEachChunk, but the chunks are spread over the JobSystem threads.
+    // Every chunk is handed out exactly once, so the callback may write to the rows it got,
+    // but nothing else in the world. No structural changes while this runs.
+    template<typename ChunkCallback>
+    void forEachChunkParallel(ChunkCallback&& callback)
+    {
+        walkChunksParallel(0, callback);
+    }
+
+    // forEachChunkChangedSince spread over the JobSystem threads. The changed chunks are
+    // picked out first, so the threads only split the work that's left.
+    template<typename T, typename ChunkCallback>
+    void forEachChunkChangedSinceParallel(uint32_t sinceTick, ChunkCallback&& callback)
+    {
+        constexpr size_t watched = detail::indexOf<T, Components...>();
+        static_assert(watched < sizeof...(Components), "Changed component has to be part of the query");
+
+        if (isSparseDriven()) {
+            forEachRow([&](SparseRow& row, size_t)
+            {
+                if (!changedSince(row, watched, sinceTick)) return;
+                markWrites(row);
+                invokeRow(callback, row);
+            }, true, 0);
+            return;
+        }
+        refresh();
+        std::vector<std::pair<const Match*, const Archetype::Chunk*>> changed;
+        for (const Match& match : active) {
+            for (const auto& chunk : match.archetype->getChunks()) {
+                if (changedSince(match, chunk, watched, sinceTick) && passesChanged(match, chunk, 0)) changed.emplace_back(&match, &chunk);
+            }
+        }
+        parallelFor(changed.size(), [&](size_t index, size_t)
+        {
+            const auto& [match, chunk] = changed[index];
+            markWrites(*match, *chunk);
+            invokeChunk(callback, *match, *chunk);
+        });
+    }
+
+    // True if any matching chunk had T's column written after sinceTick
+    template<typename T>
+    bool changedSince(uint32_t sinceTick)
+    {
+        constexpr size_t watched = detail::indexOf<T, Components...>();
+        static_assert(watched < sizeof...(Components), "Changed component has to be part of the query");
+
+        if (isSparseDriven()) {
+            bool any = false;
+            forEachRow([&](SparseRow& row, size_t) { any = any || changedSince(row, watched, sinceTick); }, false, 0);
+            return any;
+        }
+        refresh();
+        for (const Match& match : active) {
+            for (const auto& chunk : match.archetype->getChunks()) {
+                if (changedSince(match, chunk, watched, sinceTick) && passesChanged(match, chunk, 0)) return true;
+            }
+        }
+        return false;
+    }
+
+    // Parallel reduction. Each thread folds the chunks it gets into its own copy of init:
+    //     callback(Result& partial, const Entity* ents, Components*... arrays, size_t count)
+    // then the partials are combined on the calling thread, in thread order:
+    //     merge(Result& total, const Result& partial)
+    template<typename Result, typename ChunkCallback, typename MergeCallback>
+    Result reduceChunksParallel(const Result& init, ChunkCallback&& callback, MergeCallback&& merge)
+    {
+        return reduceChunks(0, init, callback, merge);
+    }
+
+    // Number of entities the query currently matches
+    size_t count()
+    {
+        return countRows(0);
+    }
+
+    // Non-empty archetypes the query currently walks
+    size_t archetypeCount()
+    {
+        refresh();
+        return active.size();
+    }
+
+    const Signature& getRequiredMask() const { return requiredMask; }
+    const Signature& getExcludedMask() const { return excludedMask; }
+
+    // True when iteration goes entity by entity: one of Components is sparse, or a
+    // sparse Optional/Without term has to be checked per entity
+    bool isSparseDriven() const { return perEntity; }
+
+private:
+    static constexpr size_t TERMS = sizeof...(Components);
+    static constexpr std::array<detail::TermKind, TERMS> kinds{ detail::QueryTerm<Components>::kind... };
+    static constexpr bool hasChangedTerms = ((detail::QueryTerm<Components>::kind == detail::TermKind::Changed) || ... || false);
+
+    // The iteration behind the public calls and Since, Changed<T> terms checked against changedTick
+    template<typename ChunkCallback>
+    void walkChunks(uint32_t changedTick, ChunkCallback& callback)
+    {
+        if (isSparseDriven()) {
+            forEachRow([&](SparseRow& row, size_t) { markWrites(row); invokeRow(callback, row); }, false, changedTick);
+            return;
+        }
+        refresh();
+        for (const Match& match : active)
+        {
+            for (const auto& chunk : match.archetype->getChunks())
+            {
+                if (!passesChanged(match, chunk, changedTick)) continue;
+                markWrites(match, chunk);
+                invokeChunk(callback, match, chunk);
+            }
+        }
+    }
+
+    template<typename ChunkCallback>
+    void walkChunksParallel(uint32_t changedTick, ChunkCallback& callback)
+    {
+        if (isSparseDriven()) {
+            forEachRow([&](SparseRow& row, size_t) { markWrites(row); invokeRow(callback, row); }, true, changedTick);
+            return;
+        }
+        refresh();
+        parallelFor(countChunks(), [&](size_t chunkIndex, size_t)
+        {
+            const Match* match;
+            size_t local;
+            const Archetype::Chunk& chunk = findChunk(chunkIndex, match, local);
+            if (!passesChanged(*match, chunk, changedTick)) return;
+            markWrites(*match, chunk);
+            invokeChunk(callback, *match, chunk);
+        });
+    }
+
+    template<typename Result, typename ChunkCallback, typename MergeCallback>
+    Result reduceChunks(uint32_t changedTick, const Result& init, ChunkCallback& callback, MergeCallback& merge)
+    {
+        JobSystem& jobs = JobSystem::Get();
+        std::vector<Result> partials(jobs.GetThreadCount(), init);
+        if (isSparseDriven()) {
+            forEachRow([&](SparseRow& row, size_t thread)
+            {
+                Result& partial = partials[thread];
+                markWrites(row);
+                auto bound = [&](const Entity* ents, auto... arraysAndCount)
+                {
+                    callback(partial, ents, arraysAndCount...);
+                };
+                invokeRow(bound, row);
+            }, true, changedTick);
+        } else {
+            forEachChunkReduce(partials, callback, changedTick);
+        }
+
+        Result total = init;
+        for (const Result& partial : partials) {
+            merge(total, partial);
+        }
+        return total;
+    }
+
+    size_t countRows(uint32_t changedTick)
+    {
+        if (isSparseDriven()) {
+            size_t total = 0;
+            forEachRow([&](SparseRow&, size_t) { ++total; }, false, changedTick);
+            return total;
+        }
+        refresh();
+        size_t total = 0;
+        for (const Match& match : active) {
+            if (!hasChangedTerms) {
+                total += match.archetype->getEntityCount();
+                continue;
+            }
+            for (const auto& chunk : match.archetype->getChunks()) {
+                if (passesChanged(match, chunk, changedTick)) total += chunk.count;
+            }
+        }
+        return total;
+    }
+
+    // Table half of reduceChunksParallel
+    template<typename Result, typename ChunkCallback>
+    void forEachChunkReduce(std::vector<Result>& partials, ChunkCallback& callback, uint32_t changedTick)
+    {
+        refresh();
+        parallelFor(countChunks(), [&](size_t chunkIndex, size_t thread)
+        {
+            const Match* match;
+            size_t local;
+            const Archetype::Chunk& chunk = findChunk(chunkIndex, match, local);
+            if (!passesChanged(*match, chunk, changedTick)) return;
+            Result& partial = partials[thread];
+            markWrites(*match, chunk);
+            auto bound = [&](const Entity* ents, auto... arraysAndCount)
+            {
+                callback(partial, ents, arraysAndCount...);
+            };
+            invokeChunk(bound, *match, chunk);
+        });
+    }
+
+    struct Match {
+        Archetype* archetype;
+        std::array<size_t, TERMS> offsets; // Column offsets inside a chunk, detail::NO_COLUMN if it has none
+        std::array<size_t, TERMS> columns; // Column indices, for the change ticks
+        std::array<const uint8_t*, TERMS> shared; // Values of the Shared terms, nullptr for the rest
+    };
+
+    // Which of Components are written through this query
+    static constexpr std::array<bool, TERMS> writes{
+        (detail::isPassed<Components> && !std::is_const_v<typename detail::QueryTerm<Components>::Component>)... };
+
+    void markWrites(const Match& match, const Archetype::Chunk& chunk) const
+    {
+        for (size_t c = 0; c < writes.size(); ++c) {
+            if (writes[c] && match.offsets[c] != detail::NO_COLUMN) match.archetype->markChanged(chunk, match.columns[c]);
+        }
+    }
+
+    static bool changedSince(const Match& match, const Archetype::Chunk& chunk, size_t component, uint32_t sinceTick)
+    {
+        return match.offsets[component] != detail::NO_COLUMN
+            && match.archetype->columnTicks(chunk)[match.columns[component]] > sinceTick;
+    }
+
+    // Every table Changed<T> term of the query passes for chunk
+    bool passesChanged(const Match& match, const Archetype::Chunk& chunk, uint32_t changedTick) const
+    {
+        if constexpr (hasChangedTerms) {
+            for (size_t c = 0; c < TERMS; ++c) {
+                if (kinds[c] == detail::TermKind::Changed && !sparseSets[c] && !changedSince(match, chunk, c, changedTick)) return false;
+            }
+        }
+        return true;
+    }
+
+    static constexpr size_t NO_DRIVER = sizeof...(Components);
+
+    // A matching entity, found through the driving sparse set or a chunk walk
+    struct SparseRow {
+        const Entity* entity;
+        Archetype* archetype;
+        EntityLocation location;
+        std::array<void*, sizeof...(Components)> pointers;
+    };
+
+    // Check every term against the entity at row.entity, filling in the pointers.
+    // row.archetype and row.location have to be set already
+    bool resolveRow(SparseRow& row, uint32_t changedTick) const
+    {
+        const Signature& signature = row.archetype->getSignature();
+        if ((signature & requiredMask) != requiredMask || (signature & excludedMask).any()) return false;
+        for (size_t c = 0; c < componentIDs.size(); ++c)
+        {
+            void* value = sparseSets[c] ? sparseSets[c]->get(*row.entity)
+                        : kinds[c] == detail::TermKind::Shared ? const_cast<uint8_t*>(row.archetype->getSharedValue(componentIDs[c]))
+                        : splitTerms[c] ? row.archetype->getColumnData(row.location, componentIDs[c])
+                        : row.archetype->getComponentData(row.location, componentIDs[c]);
+            switch (kinds[c])
+            {
+            case detail::TermKind::Without:
+                if (value) return false;
+                break;
+            case detail::TermKind::Optional:
+                break;
+            case detail::TermKind::Changed:
+                if (!value || !changedSince(row, c, changedTick)) return false;
+                break;
+            default:
+                if (!value) return false;
+                break;
+            }
+            row.pointers[c] = value;
+        }
+        return true;
+    }
+
+    // JobSystem::ParallelFor that tags the commands each job records with its index, so they flush
+    // in job order. Commands recorded after it sort after the jobs'
+    template<typename Task>
+    void parallelFor(size_t count, Task&& task)
+    {
+        CommandSource caller = world->getCommandSource();
+        if (caller.job != 0) {
+            // Nested in another job, so it runs serially on this thread under that job's tag
+            JobSystem::Get().ParallelFor(count, task);
+            return;
+        }
+        ++caller.phase;
+        JobSystem::Get().ParallelFor(count, [&](size_t index, size_t thread)
+        {
+            const CommandSource outer = world->getCommandSource();
+            world->setCommandSource({ caller.system, caller.phase, static_cast<uint32_t>(index + 1) });
+            task(index, thread);
+            world->setCommandSource(outer);
+        });
+        ++caller.phase;
+        world->setCommandSource(caller);
+    }
+
+    // fn(SparseRow& row, size_t thread) for every matching entity, from the driving set if there is one,
+    // otherwise from the matching chunks
+    template<typename RowFn>
+    void forEachRow(RowFn&& fn, bool parallel, uint32_t changedTick)
+    {
+        if (driver == NO_DRIVER) {
+            forEachChunkRow(fn, parallel, changedTick);
+            return;
+        }
+        auto visit = [&](size_t index, size_t thread)
+        {
+            SparseRow row;
+            row.entity = sparseSets[driver]->entities() + index;
+            if (world->locate(*row.entity, row.archetype, row.location) && resolveRow(row, changedTick)) fn(row, thread);
+        };
+        const size_t count = sparseSets[driver]->size();
+        if (parallel) {
+            parallelFor(count, visit);
+        } else {
+            for (size_t i = 0; i < count; ++i) visit(i, JobSystem::GetThreadIndex());
+        }
+    }
+
+    // Archetype and Changed terms still skip whole chunks, only the sparse terms are checked per row
+    template<typename RowFn>
+    void forEachChunkRow(RowFn& fn, bool parallel, uint32_t changedTick)
+    {
+        refresh();
+        auto visit = [&](size_t chunkIndex, size_t thread)
+        {
+            const Match* match;
+            size_t local;
+            const Archetype::Chunk& chunk = findChunk(chunkIndex, match, local);
+            if (!passesChanged(*match, chunk, changedTick)) return;
+            SparseRow row;
+            row.archetype = match->archetype;
+            for (size_t r = 0; r < chunk.count; ++r)
+            {
+                row.entity   = chunk.entities() + r;
+                row.location = { static_cast<uint32_t>(local), static_cast<uint32_t>(r) };
+                if (resolveRow(row, changedTick)) fn(row, thread);
+            }
+        };
+        const size_t count = countChunks();
+        if (parallel) {
+            parallelFor(count, visit);
+        } else {
+            for (size_t i = 0; i < count; ++i) visit(i, JobSystem::GetThreadIndex());
+        }
+    }
+
+    template<typename ChunkCallback>
+    static void invokeRow(ChunkCallback& callback, const SparseRow& row)
+    {
+        detail::invokeRowCallback<Components...>(callback, row.entity, row.pointers, row.archetype->getChunkCapacity(), row.location.row);
+    }
+
+    template<typename ChunkCallback>
+    static void invokeChunk(ChunkCallback& callback, const Match& match, const Archetype::Chunk& chunk)
+    {
+        detail::invokeChunkCallback<Components...>(callback, chunk, match.offsets, match.shared, match.archetype->getChunkCapacity());
+    }
+
+    // Sparse components have no ticks, they always count as changed
+    bool changedSince(const SparseRow& row, size_t component, uint32_t sinceTick) const
+    {
+        if (sparseSets[component]) return true;
+        const int column = row.archetype->compMap[componentIDs[component]];
+        if (column < 0) return false;
+        const auto& chunk = row.archetype->getChunks()[row.location.chunk];
+        return row.archetype->loadTick(chunk, static_cast<size_t>(column)) > sinceTick;
+    }
+
+    // Rows of one chunk can be on several threads at once, so the stamp goes in atomically
+    void markWrites(const SparseRow& row) const
+    {
+        for (size_t c = 0; c < writes.size(); ++c) {
+            if (writes[c] && !sparseSets[c] && row.pointers[c]) row.archetype->markChangedShared(row.location, componentIDs[c]);
+        }
+    }
+
+    size_t countChunks() const
+    {
+        return chunkStarts.back();
+    }
+
+    // Flat chunk index -> chunk, and its index inside the archetype.
+    // Binary search over the chunk counts refresh() summed up
+    const Archetype::Chunk& findChunk(size_t chunkIndex, const Match*& outMatch, size_t& outLocal) const
+    {
+        if (chunkIndex >= countChunks()) {
+            throw std::out_of_range("Query chunk index out of range!");
+        }
+        // Every active match has at least one chunk, so the starts are strictly increasing
+        const size_t index = static_cast<size_t>(std::upper_bound(chunkStarts.begin(), chunkStarts.end(), chunkIndex) - chunkStarts.begin()) - 1;
+        outMatch = &active[index];
+        outLocal = chunkIndex - chunkStarts[index];
+        return active[index].archetype->getChunks()[outLocal];
+    }
+
+    // Pick up archetypes created since we last looked, and re-pick the non-empty ones and
+    // recount their chunks if any archetype gained or lost a chunk since (see World::getOccupancyVersion).
+    // Systems that share a query can get here from different threads at once, so the
+    // rebuilding is done under a lock, and whoever gets the lock second finds it current and
+    // leaves the lists alone while the first one walks them. Both only change through
+    // structural changes, which never run alongside other systems, so nothing moves while we read it.
+    void refresh()
+    {
+        const auto& archetypeList = world->getArchetypeList();
+        const uint64_t occupancy  = world->getOccupancyVersion();
+        auto current = [&]() {
+            return archetypesSeen.load(std::memory_order_acquire) == archetypeList.size()
+                && activeVersion.load(std::memory_order_acquire) == occupancy;
+        };
+        if (current()) return;
+
+        std::lock_guard<std::mutex> lock(refreshMutex);
+        if (current()) return;
+        size_t seen = archetypesSeen.load(std::memory_order_relaxed);
+        for (; seen < archetypeList.size(); ++seen)
+        {
+            Archetype* arch = archetypeList[seen];
+            const Signature& signature = arch->getSignature();
+            if ((signature & requiredMask) != requiredMask || (signature & excludedMask).any()) continue;
+
+            Match match{ arch, {}, {}, {} };
+            for (size_t c = 0; c < componentIDs.size(); ++c) {
+                match.shared[c] = kinds[c] == detail::TermKind::Shared ? arch->getSharedValue(componentIDs[c]) : nullptr;
+                const int column = arch->compMap[componentIDs[c]];
+                if (column < 0 || kinds[c] == detail::TermKind::Without) {
+                    match.offsets[c] = detail::NO_COLUMN;
+                    match.columns[c] = 0;
+                    continue;
                 }
+                match.columns[c] = static_cast<size_t>(column);
+                match.offsets[c] = arch->components[match.columns[c]].offset;
             }
+            matches.push_back(match);
+        }
+
+        // Empty archetypes (EntityBuilder's stepping stones, despawned levels) aren't walked at all
+        // Built on the side and swapped in whole, never edited in place
+        std::vector<Match> rebuilt;
+        std::vector<size_t> starts{ 0 };
+        for (const Match& match : matches) {
+            if (match.archetype->getEntityCount() == 0) continue;
+            rebuilt.push_back(match);
+            starts.push_back(starts.back() + match.archetype->getChunks().size());
+        }
+        active.swap(rebuilt);
+        chunkStarts.swap(starts);
+        activeVersion.store(occupancy, std::memory_order_release);
+        archetypesSeen.store(seen, std::memory_order_release);
+    }
+
+    World* world;
+    std::array<int, sizeof...(Components)> componentIDs;
+    std::array<SparseSet*, sizeof...(Components)> sparseSets; // nullptr for table components
+    std::array<bool, sizeof...(Components)> splitTerms{};     // Field-split columns, found by column start
+    size_t driver = NO_DRIVER; // First sparse Required/With/Changed term, its set drives iteration
+    bool perEntity = false;    // See isSparseDriven()
+    Signature requiredMask;    // Table and shared components only
+    Signature excludedMask;    // Table Without<T> terms
+    std::vector<Match> matches; // Every matching archetype
+    std::vector<Match> active;  // The non-empty ones, what iteration walks
+    std::vector<size_t> chunkStarts{ 0 }; // Flat index of each active match's first chunk, then the total
+    std::atomic<size_t> archetypesSeen{0};
+    std::atomic<uint64_t> activeVersion{UINT64_MAX};
+    std::mutex refreshMutex;
+};
+
+template<typename... Components>
+Query<Components...>& World::query()
+{
+    const size_t slot = detail::querySlot<Components...>();
+    if (slot >= MAX_QUERY_TYPES) {
+        throw std::runtime_error("Too many query types, raise secs::MAX_QUERY_TYPES!");
+    }
+    QueryBase* cached = querySlots[slot].load(std::memory_order_acquire);
+    if (!cached) {
+        // Systems in one stage can ask for a query nobody has built yet at the same time
+        std::lock_guard<std::mutex> lock(queryMutex);
+        cached = querySlots[slot].load(std::memory_order_relaxed);
+        if (!cached) {
+            cachedQueries.push_back(std::make_unique<Query<Components...>>(*this));
+            cached = cachedQueries.back().get();
+            querySlots[slot].store(cached, std::memory_order_release);
+        }
+    }
+    return static_cast<Query<Components...>&>(*cached);
+}
+
+/*
+    ===================
+    COMMAND BUFFER
+    ===================
+    - Records structural changes (create/destroy, add/remove) instead of doing them,
+      so they can be issued while chunks are being iterated.
+    - createEntity() hands back a pending handle. Later commands can use it, the world
+      can't: the entity gets its ID at the flush, world.resolve(handle) tells which.
+    - World::flushCommands() applies every buffer in one pass: destroys first, then
+      each entity goes straight to its final archetype, grouped by that archetype.
+    - Buffers are per JobSystem thread, but every command is tagged with its source
+      (see World::getCommandSource()) and the flush goes by that: commands recorded
+      outside of systems first, then each system's in schedule order, inside a system
+      in the order it recorded them, a parallel query's by job index.
+      So the outcome and the IDs created entities get don't depend on thread timing.
+      Only commands recorded outside of systems and queries on several threads at once
+      have no order between those threads.
+    - Commands on entities that are dead by flush time are dropped.
+*/
+class PE_API CommandBuffer
+{
+public:
+    // slot is the buffer's index in the world, pending handles carry it
+    explicit CommandBuffer(uint32_t slot)
+        : slot(slot)
+    {
+    }
+
+    ~CommandBuffer()
+    {
+        clear();
+    }
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    Entity createEntity()
+    {
+        Entity e{ PENDING_ID | nextPending, slot };
+        nextPending = (nextPending + 1) & ~PENDING_ID;
+        commands.push_back({ e, source, Op::Create, -1, nullptr, nullptr, nullptr });
+        return e;
+    }
+
+    void destroyEntity(Entity e)
+    {
+        commands.push_back({ e, source, Op::Destroy, -1, nullptr, nullptr, nullptr });
+    }
+
+    // Adds T, or overwrites it if the entity already has one
+    template<typename T>
+    void addComponent(Entity e, const T& value = T{})
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components can't be deferred");
+        void* stored = new (allocatePayload(sizeof(T), alignof(T))) T(value);
+
+        commands.push_back({ e, source, Op::Add, ComponentRegistry::getID<T>(), stored,
+            [](void* dst, void* src) { *static_cast<T*>(dst) = std::move(*static_cast<T*>(src)); },
+            [](void* value) { static_cast<T*>(value)->~T(); } });
+    }
+
+    template<typename T>
+    void removeComponent(Entity e)
+    {
+        commands.push_back({ e, source, Op::Remove, ComponentRegistry::getID<T>(), nullptr, nullptr, nullptr });
+    }
+
+    bool empty() const { return commands.empty(); }
+
+    // Drop everything recorded so far
+    void clear()
+    {
+        for (const Command& cmd : commands) {
+            if (cmd.destroy) cmd.destroy(cmd.value);
         }
+        commands.clear();
+        // Keep the first block around for the next frame
+        if (payload.size() > 1) payload.resize(1);
+        if (!payload.empty()) payload.front().used = 0;
     }
 
 private:
-    bool matchesAll(const Archetype* arch) const
+    friend class World;
+
+    enum class Op : uint8_t { Create, Destroy, Add, Remove };
+
+    // Pending handles have this bit set in the ID and their buffer's slot as generation.
+    // No live entity has it, so the world never mistakes one for a real handle
+    static constexpr uint32_t PENDING_ID = 0x80000000u;
+
+    struct Command {
+        Entity entity;
+        CommandSource source;
+        Op op;
+        int compID;
+        void* value; // Component value for Add, lives in payload
+        void (*assign)(void* dst, void* src);
+        void (*destroy)(void* value);
+    };
+
+    // Values are constructed in place and never move until the flush, so components
+    // that aren't safe to memcpy (std::string and friends) are fine in here
+    struct PayloadBlock {
+        std::unique_ptr<uint8_t[]> memory;
+        size_t size = 0;
+        size_t used = 0;
+    };
+
+    static constexpr size_t PAYLOAD_BLOCK_SIZE = 4096;
+
+    uint8_t* allocatePayload(size_t size, size_t align)
     {
-        for (int compID : requiredComponents) {
-            if (!arch->hasComponent(compID)) return false;
+        if (!payload.empty()) {
+            PayloadBlock& block = payload.back();
+            size_t offset = (block.used + align - 1) & ~(align - 1);
+            if (offset + size <= block.size) {
+                block.used = offset + size;
+                return block.memory.get() + offset;
+            }
         }
-        return true;
+        PayloadBlock block;
+        block.size   = std::max(size, PAYLOAD_BLOCK_SIZE);
+        block.memory = std::make_unique<uint8_t[]>(block.size);
+        block.used   = size;
+        payload.push_back(std::move(block));
+        return payload.back().memory.get();
     }
 
-    std::vector<int> requiredComponents;
-    Callback callback;
+    uint32_t slot;
+    CommandSource source;   // Tag for what gets recorded now
+    uint32_t nextPending = 0;
+    uint32_t pendingBase = 0;  // Pending index created[0] belongs to
+    std::vector<Entity> created; // What the last flush made of the pending handles from pendingBase on
+    std::vector<Command> commands;
+    std::vector<PayloadBlock> payload;
 };
 
-// ============ Detail namespace for type expansion trick ============
-namespace detail
+inline World::World()
+    : World(std::make_unique<ChunkArena>())
 {
-    // We define a helper that, given the user callback, the arrays, and the entity list,
-    // calls: callback(entities, typedPtr1, typedPtr2, ..., count)
+}
 
-    template <typename... Components, typename ChunkCallback, size_t... Indices>
-    void invokeChunkCallbackImpl(
-        ChunkCallback& cb,
-        const std::vector<Entity>& entities,
-        const std::vector<void*>& arrays,
-        size_t entityCount,
-        std::index_sequence<Indices...>)
+inline World::World(std::unique_ptr<ChunkAllocator> allocator)
+    : ownedAllocator(std::move(allocator)), chunkAllocator(ownedAllocator.get())
+{
+    const size_t threads = JobSystem::Get().GetThreadCount();
+    commandBuffers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        commandBuffers.push_back(std::make_unique<CommandBuffer>(static_cast<uint32_t>(i)));
+    }
+}
+
+inline World::World(ChunkAllocator& sharedAllocator)
+    : World(std::unique_ptr<ChunkAllocator>())
+{
+    chunkAllocator = &sharedAllocator;
+}
+
+inline World::~World()
+{
+    // Our own allocator dies right after the archetypes, no point handing chunks back one by one
+    if (ownedAllocator) {
+        for (Archetype* arch : archetypeList) {
+            arch->abandonChunks();
+        }
+    }
+}
+
+inline CommandBuffer& World::commands()
+{
+    return *commandBuffers[JobSystem::GetThreadIndex()];
+}
+
+inline Entity World::resolve(Entity e) const
+{
+    if (!(e.id & CommandBuffer::PENDING_ID) || e.generation >= commandBuffers.size()) return e;
+    const CommandBuffer& buffer = *commandBuffers[e.generation];
+    const uint32_t index = (e.id - buffer.pendingBase) & ~CommandBuffer::PENDING_ID;
+    // Handles whose commands were cleared before the flush never got an entity
+    if (index >= buffer.created.size() || (buffer.created[index].id & CommandBuffer::PENDING_ID)) return e;
+    return buffer.created[index];
+}
+
+inline CommandSource World::getCommandSource() const
+{
+    return commandBuffers[JobSystem::GetThreadIndex()]->source;
+}
+
+inline void World::setCommandSource(const CommandSource& source)
+{
+    commandBuffers[JobSystem::GetThreadIndex()]->source = source;
+}
+
+inline void World::flushCommands()
+{
+    // Everything that was recorded, in source order. Stable sort keeps the commands of one source
+    // in the order they were issued, whichever thread that was on.
+    std::vector<CommandBuffer::Command*> recorded;
+    for (auto& buffer : commandBuffers) {
+        for (auto& cmd : buffer->commands) {
+            recorded.push_back(&cmd);
+        }
+    }
+    std::stable_sort(recorded.begin(), recorded.end(),
+        [](const CommandBuffer::Command* a, const CommandBuffer::Command* b) { return a->source < b->source; });
+
+    // Created entities get their slots now and in that order, so their IDs come out the same every run.
+    // No row yet: they go straight to their final archetype
+    for (auto& buffer : commandBuffers) {
+        buffer->pendingBase = (buffer->pendingBase + static_cast<uint32_t>(buffer->created.size())) & ~CommandBuffer::PENDING_ID;
+        buffer->created.assign((buffer->nextPending - buffer->pendingBase) & ~CommandBuffer::PENDING_ID, Entity{ CommandBuffer::PENDING_ID, 0 });
+    }
+    std::vector<uint32_t> created;
+    for (const CommandBuffer::Command* cmd : recorded) {
+        if (cmd->op != CommandBuffer::Op::Create) continue;
+        CommandBuffer& buffer = *commandBuffers[cmd->entity.generation];
+        const Entity e = allocateEntity();
+        buffer.created[(cmd->entity.id - buffer.pendingBase) & ~CommandBuffer::PENDING_ID] = e;
+        created.push_back(e.id);
+    }
+    for (CommandBuffer::Command* cmd : recorded) {
+        cmd->entity = resolve(cmd->entity);
+    }
+    std::sort(created.begin(), created.end());
+    auto isCreated = [&](Entity e) {
+        return std::binary_search(created.begin(), created.end(), e.id)
+            && entityRecords[e.id].archetype == nullptr
+            && entityRecords[e.id].generation == e.generation;
+    };
+
+    // Then grouped per entity, each entity's commands still in source order
+    std::stable_sort(recorded.begin(), recorded.end(),
+        [](const CommandBuffer::Command* a, const CommandBuffer::Command* b) { return a->entity.id < b->entity.id; });
+
+    // One plan per entity: where it ends up, and which commands to replay for the component values
+    struct Plan {
+        Entity entity;
+        Archetype* target; // nullptr => destroy
+        bool fresh;        // Created by a command, has no row yet
+        size_t first, last;
+        size_t group = 0;
+    };
+    std::vector<Plan> plans;
+    Archetype* empty = nullptr;
+    for (size_t begin = 0; begin < recorded.size();)
     {
-        // We'll cast each arrays[Indices] to the corresponding type pointer.
-        // So arrays[0] => Components0 pointer, arrays[1] => Components1 pointer, etc.
-        cb(
-            entities,
-            reinterpret_cast<Components*>(arrays[Indices])...,
-            entityCount
-        );
+        size_t end = begin;
+        while (end < recorded.size() && recorded[end]->entity.id == recorded[begin]->entity.id) ++end;
+
+        // Only commands for the current generation count, the rest target something long gone
+        Entity e{ recorded[begin]->entity.id, 0 };
+        Archetype* arch = nullptr;
+        bool fresh = false;
+        for (size_t i = begin; i < end && !arch; ++i) {
+            Entity candidate = recorded[i]->entity;
+            if (isAlive(candidate)) {
+                e = candidate;
+                arch = entityRecords[e.id].archetype;
+            }
+            else if (isCreated(candidate)) {
+                e = candidate;
+                if (!empty) empty = getOrCreateArchetype(Signature{});
+                arch = empty;
+                fresh = true;
+            }
+        }
+
+        if (arch) {
+            Archetype* target = arch;
+            for (size_t i = begin; i < end && target; ++i) {
+                const auto& cmd = *recorded[i];
+                if (cmd.entity.generation != e.generation) continue;
+                switch (cmd.op) {
+                    case CommandBuffer::Op::Create: break;
+                    case CommandBuffer::Op::Destroy: target = nullptr; break;
+                    case CommandBuffer::Op::Add:
+                        if (ComponentRegistry::isShared(cmd.compID)) {
+                            target = getSharedTarget(target, cmd.compID, cmd.value);
+                        }
+                        else if (!ComponentRegistry::isSparse(cmd.compID) && !target->hasComponent(cmd.compID)) {
+                            target = getAddTarget(target, cmd.compID);
+                        }
+                        break;
+                    case CommandBuffer::Op::Remove:
+                        if (target->hasComponent(cmd.compID)) target = getRemoveTarget(target, cmd.compID);
+                        break;
+                }
+            }
+            plans.push_back({ e, target, fresh, begin, end });
+        }
+        begin = end;
     }
 
-    template <typename... Components, typename ChunkCallback>
-    void invokeChunkCallback(
-        ChunkCallback& cb,
-        const std::vector<Entity>& entities,
-        const std::vector<void*>& arrays,
-        size_t entityCount
-    )
+    // Destroys first, so the rows they free get filled by the moves that follow.
+    // Created entities that are destroyed again never get a row, the sweep at the end frees them.
+    std::vector<Entity> destroyed;
+    for (const Plan& plan : plans) {
+        if (!plan.target && !plan.fresh) destroyed.push_back(plan.entity);
+    }
+    destroyEntities(destroyed);
+
+    // Group the rest by target archetype, in order of first appearance
+    std::vector<Archetype*> targets;
+    for (Plan& plan : plans) {
+        if (!plan.target) continue;
+        auto it = std::find(targets.begin(), targets.end(), plan.target);
+        plan.group = static_cast<size_t>(it - targets.begin());
+        if (it == targets.end()) targets.push_back(plan.target);
+    }
+    std::stable_sort(plans.begin(), plans.end(), [](const Plan& a, const Plan& b) { return a.group < b.group; });
+
+    for (const Plan& plan : plans)
     {
-        // Generate a compile-time index sequence for the size of the parameter pack
-        invokeChunkCallbackImpl<Components...>(
-            cb,
-            entities,
-            arrays,
-            entityCount,
-            std::index_sequence_for<Components...>{}
-        );
+        if (!plan.target) continue;
+        EntityRecord& record = entityRecords[plan.entity.id];
+        Signature before;     // What it had, to tell which components the move added
+        Signature sharedSwap; // Shared components it kept with another value
+        if (plan.fresh) {
+            record.archetype = plan.target;
+            record.location  = plan.target->addEntity(plan.entity);
+        }
+        else {
+            Archetype* from = record.archetype;
+            before = from->getSignature();
+            for (int compID = 0; compID < MAX_COMPONENTS; ++compID) {
+                if (before.test(compID) && plan.target->hasComponent(compID) && ComponentRegistry::isShared(compID)
+                    && from->getSharedKey()[compID] != plan.target->getSharedKey()[compID]) {
+                    sharedSwap.set(compID);
+                }
+            }
+            // Whatever the move drops goes first, while its value is still there
+            notify(HookEvent::Remove, before & ~plan.target->getSignature(), { &plan.entity, 1 });
+            moveEntityToArchetype(plan.entity, record, plan.target);
+        }
+
+        // Replay the adds in order, the last one for a component wins.
+        // Sparse components never changed the target, their adds and removes are applied here.
+        // Shared ones have no row to write, their values went into the target
+        for (size_t i = plan.first; i < plan.last; ++i) {
+            const auto& cmd = *recorded[i];
+            if (cmd.entity.generation != plan.entity.generation) continue;
+            if (cmd.op == CommandBuffer::Op::Add && ComponentRegistry::isSparse(cmd.compID)) {
+                SparseSet& set = getSparseSet(cmd.compID);
+                const bool had = set.contains(plan.entity);
+                cmd.assign(set.emplace(plan.entity), cmd.value);
+                notifyOne(had ? HookEvent::Change : HookEvent::Add, cmd.compID, plan.entity);
+            }
+            else if (cmd.op == CommandBuffer::Op::Add) {
+                void* dst = plan.target->getComponentData(record.location, cmd.compID);
+                if (dst) {
+                    cmd.assign(dst, cmd.value);
+                } else if (ComponentRegistry::isSplit(cmd.compID) && plan.target->hasComponent(cmd.compID)) {
+                    plan.target->writeRow(record.location, cmd.compID, cmd.value); // Trivially copyable, bytes will do
+                }
+                // An overwrite that didn't move the row is a write like any other
+                plan.target->markChanged(record.location, cmd.compID);
+            }
+            else if (cmd.op == CommandBuffer::Op::Remove && ComponentRegistry::isSparse(cmd.compID)) {
+                SparseSet& set = getSparseSet(cmd.compID);
+                if (set.contains(plan.entity)) {
+                    notifyOne(HookEvent::Remove, cmd.compID, plan.entity);
+                    set.remove(plan.entity);
+                }
+            }
+        }
+        notify(HookEvent::Add, plan.target->getSignature() & ~before, { &plan.entity, 1 });
+        notify(HookEvent::Change, sharedSwap, { &plan.entity, 1 });
     }
-} // namespace detail
+
+    for (uint32_t id : created) {
+        if (!entityRecords[id].archetype) releaseSlot(id);
+    }
+
+    for (auto& buffer : commandBuffers) {
+        buffer->clear();
+    }
+}
 
 class PE_API EntityBuilder {
 public:
@@ -572,51 +3806,151 @@ private:
     bool entityCreated;
 };
     
-// A helper function if you want chunk-based queries
-template<typename... Components, typename ChunkCallback>
-void queryChunks(World& world, ChunkCallback callback)
+/*
+    ===================
+    SYSTEM
+    ===================
+    - Declared with its component types, e.g. makeSystem<Spin, Transform>(...).
+    - On execute it runs the world's cached query for those types and hands the
+      callback typed column pointers once per chunk, so the per-entity loop lives
+      inside the callback where the compiler can inline and vectorize it.
+    - The only indirect call is one per system per frame.
+    - Const component types are reads, the rest are writes. The scheduler uses
+      that to run systems side by side, so anything touched outside the system's
+      own query has to be declared with alsoReads<T>() / alsoWrites<T>().
+*/
+class PE_API System
 {
-    // 1) Gather the component IDs for each type
-    std::vector<int> requiredIDs = { ComponentRegistry::getID<Components>()... };
-
-    // 2) Iterate all archetypes in the world
-    const auto& archMap = world.getAllArchetypes();
-    for (auto& [sig, archePtr] : archMap)
-    {
-        // Check if archetype has *all* required components
-        bool hasAll = true;
-        for (int cid : requiredIDs) {
-            if (!archePtr->hasComponent(cid)) {
-                hasAll = false;
-                break;
-            }
-        }
-        if (!hasAll) continue;
+public:
+    using Runner = std::function<void(World&)>;
 
-        // Gather pointers to each component array
-        std::vector<void*> arrays;
-        arrays.reserve(requiredIDs.size());
-        for (int cid : requiredIDs) {
-            auto it = archePtr->compMap.find(cid);
-            if (it == archePtr->compMap.end()) {
-                arrays.push_back(nullptr);
-            }
-            else {
-                auto& cData = archePtr->components[it->second];
-                arrays.push_back(cData.data.empty() ? nullptr : cData.data.data());
-            }
-        }
+    System(std::string systemName, Signature readMask, Signature writeMask, Runner runner)
+        : name(std::move(systemName))
+        , reads(readMask)
+        , writes(writeMask)
+        , runner(std::move(runner))
+    {
+    }
 
-        // Get the entity list
-        auto& entities = archePtr->getEntities();
-        size_t entityCount = entities.size();
-        if (entityCount == 0) {
-            continue;
-        }
+    void execute(World& world)
+    {
+        runner(world);
+    }
+
+    // Extra component access outside the system's own query
+    template<typename T>
+    System& alsoReads()
+    {
+        reads.set(ComponentRegistry::getID<T>());
+        return *this;
+    }
+
+    template<typename T>
+    System& alsoWrites()
+    {
+        writes.set(ComponentRegistry::getID<T>());
+        return *this;
+    }
+
+    // Has to run on the main thread (GL, ImGui, engine globals)
+    System& onMainThread()
+    {
+        mainThread = true;
+        return *this;
+    }
+
+    // Runs with nothing else alongside it, e.g. when it changes the world's structure
+    // directly instead of going through world.commands()
+    System& exclusive()
+    {
+        exclusiveAccess = true;
+        return *this;
+    }
+
+    // Two systems conflict when one writes something the other touches.
+    // Exclusive systems conflict with everything.
+    bool conflictsWith(const System& other) const
+    {
+        if (exclusiveAccess || other.exclusiveAccess) return true;
+        return (writes & (other.reads | other.writes)).any()
+            || (other.writes & reads).any();
+    }
+
+    const std::string& getName() const { return name; }
+    Signature getComponentMask() const { return reads | writes; }
+    const Signature& getReadMask() const { return reads; }
+    const Signature& getWriteMask() const { return writes; }
+    bool isMainThreadOnly() const { return mainThread || exclusiveAccess; }
+    bool isExclusive() const { return exclusiveAccess; }
+
+private:
+    std::string name;
+    Signature reads;
+    Signature writes;
+    bool mainThread = false;
+    bool exclusiveAccess = false;
+    Runner runner;
+};
+
+namespace detail
+{
+    // Components the query terms touch. With/Without only look at the archetype, not the data
+    template<typename... Components>
+    Signature componentMask()
+    {
+        Signature mask;
+        ((QueryTerm<Components>::kind == TermKind::With || QueryTerm<Components>::kind == TermKind::Without
+            ? mask : mask.set(ComponentRegistry::getID<typename QueryTerm<Components>::Component>())), ...);
+        return mask;
+    }
+
+    // Components the system only reads (declared const, or only checked by Changed<T>) vs the ones it writes
+    template<typename... Components>
+    Signature readMask()
+    {
+        Signature mask;
+        ((std::is_const_v<typename QueryTerm<Components>::Component> || QueryTerm<Components>::kind == TermKind::Changed
+            ? mask.set(ComponentRegistry::getID<typename QueryTerm<Components>::Component>()) : mask), ...);
+        return mask & componentMask<Components...>();
+    }
 
-        // Invoke the user callback with typed pointers
-        detail::invokeChunkCallback<Components...>(callback, entities, arrays, entityCount);
+    template<typename... Components>
+    Signature writeMask()
+    {
+        return componentMask<Components...>() & ~readMask<Components...>();
     }
+} // namespace detail
+
+// System that runs callback(const Entity* ents, Components*... arrays, size_t count) for every matching chunk
+template<typename... Components, typename ChunkCallback>
+System makeSystem(std::string name, ChunkCallback callback)
+{
+    return System(std::move(name), detail::readMask<Components...>(), detail::writeMask<Components...>(),
+        [callback](World& world) mutable
+        {
+            world.query<Components...>().forEachChunk(callback);
+        });
+}
+
+// Same, but the chunks are spread over the JobSystem threads.
+// The callback may only touch the rows it was handed.
+template<typename... Components, typename ChunkCallback>
+System makeParallelSystem(std::string name, ChunkCallback callback)
+{
+    return System(std::move(name), detail::readMask<Components...>(), detail::writeMask<Components...>(),
+        [callback](World& world)
+        {
+            world.query<Components...>().forEachChunkParallel(callback);
+        });
+}
+
+// A helper function if you want chunk-based queries.
+// The callback runs once per chunk: callback(const Entity* ents, Components*... arrays, size_t count)
+// Goes through the World's cached Query, so there's no per-call scan or allocation.
+template<typename... Components, typename ChunkCallback>
+void queryChunks(World& world, ChunkCallback callback)
+{
+    world.query<Components...>().forEachChunk(callback);
 }
 
 } // end namespace secs
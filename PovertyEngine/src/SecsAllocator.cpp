@@ -0,0 +1,70 @@
+#include "Secs.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace secs
+{
+
+#ifdef __linux__
+namespace
+{
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    // Anonymous mapping of bytes starting on a huge page boundary, so transparent huge pages can back all of it
+    void* mapHugeAligned(size_t bytes)
+    {
+        const size_t padded = bytes + HUGE_PAGE_SIZE;
+        void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+
+        // Trim the unaligned head and whatever is past the end
+        const uintptr_t start   = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (aligned != start) {
+            munmap(raw, aligned - start);
+        }
+        const size_t tail = padded - (aligned - start) - bytes;
+        if (tail > 0) {
+            munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+}
+#endif
+
+ChunkArena::Block ChunkArena::acquireBlock(size_t bytes) const
+{
+#ifdef __linux__
+    if (hugePages) {
+        const size_t size = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        // Explicit huge pages only exist if someone reserved them (vm.nr_hugepages)
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            return { memory, size, true, true };
+        }
+        // Otherwise ask for transparent ones
+        memory = mapHugeAligned(size);
+        if (memory) {
+            const bool advised = madvise(memory, size, MADV_HUGEPAGE) == 0;
+            return { memory, size, true, advised };
+        }
+    }
+#endif
+    void* memory = ::operator new(bytes, std::align_val_t(COLUMN_ALIGNMENT));
+    return { memory, bytes, false, false };
+}
+
+void ChunkArena::releaseBlock(const Block& block)
+{
+#ifdef __linux__
+    if (block.mapped) {
+        munmap(block.memory, block.size);
+        return;
+    }
+#endif
+    ::operator delete(block.memory, std::align_val_t(COLUMN_ALIGNMENT));
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "Secs.h"
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace secs
+{
+
+/*
+    ===================
+    HASH INDEX
+    ===================
+    Entities by a key taken from one of their components, e.g. by name:
+        secs::HashIndex<Name, std::string> byName(world, &Name::name);
+        std::optional<secs::Entity> player = byName.find("PlayerCar");
+    - Fills itself from what's already in the world, then follows the Add/Remove/Change hooks,
+      so a lookup is a hash probe instead of a scan.
+    - Writes through a pointer reach the index when World::publishChanges() reports them
+      (see HOOKS); until then a lookup sees the old key.
+    - Several entities may share a key.
+    Lives as long as the world does or shorter. Not copyable or movable, the hooks point back at it.
+*/
+template<typename T, typename Key, typename Hash = std::hash<Key>>
+class HashIndex
+{
+public:
+    using KeyOf = std::function<Key(const T&)>;
+
+    HashIndex(World& world, KeyOf keyOf)
+        : world(world), keyOf(std::move(keyOf))
+    {
+        const int compID = ComponentRegistry::getID<T>();
+        world.forEachWith(compID, [this](Entity e) {
+            if (auto value = this->world.getComponentValue<const T>(e)) insert(e, *value);
+        });
+        hooks[0] = world.onAdd<T>([this](Entity e, const T& value) { update(e, value); });
+        hooks[1] = world.onRemove<T>([this](Entity e, const T&) { erase(e); });
+        hooks[2] = world.onChange<T>([this](Entity e, const T& value) { update(e, value); });
+    }
+
+    // Keyed on a member of T
+    HashIndex(World& world, Key T::*member)
+        : HashIndex(world, KeyOf([member](const T& value) { return value.*member; }))
+    {
+    }
+
+    ~HashIndex()
+    {
+        for (HookID id : hooks) world.removeHook(id);
+    }
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    // An entity filed under key, empty if there's none
+    std::optional<Entity> find(const Key& key) const
+    {
+        auto it = byKey.find(key);
+        return it != byKey.end() ? std::optional<Entity>(it->second) : std::nullopt;
+    }
+
+    // Every entity filed under key
+    std::vector<Entity> findAll(const Key& key) const
+    {
+        std::vector<Entity> found;
+        auto [first, last] = byKey.equal_range(key);
+        for (auto it = first; it != last; ++it) found.push_back(it->second);
+        return found;
+    }
+
+    bool contains(const Key& key) const { return byKey.find(key) != byKey.end(); }
+
+    // Indexed entities
+    size_t size() const { return keys.size(); }
+
+private:
+    void insert(Entity e, const T& value)
+    {
+        Key key = keyOf(value);
+        byKey.emplace(key, e);
+        keys.emplace(e.id, std::move(key));
+    }
+
+    void erase(Entity e)
+    {
+        auto it = keys.find(e.id);
+        if (it == keys.end()) return;
+        auto [first, last] = byKey.equal_range(it->second);
+        for (auto entry = first; entry != last; ++entry) {
+            if (entry->second == e) {
+                byKey.erase(entry);
+                break;
+            }
+        }
+        keys.erase(it);
+    }
+
+    // Re-file e if its key moved. Change is reported per chunk, most rows come back unchanged
+    void update(Entity e, const T& value)
+    {
+        auto it = keys.find(e.id);
+        if (it != keys.end() && it->second == keyOf(value)) return;
+        erase(e);
+        insert(e, value);
+    }
+
+    World& world;
+    KeyOf keyOf;
+    std::unordered_multimap<Key, Entity, Hash> byKey;
+    std::unordered_map<uint32_t, Key> keys; // Entity::id -> the key it's filed under
+    HookID hooks[3] = {};
+};
+
+}
@@ -0,0 +1,252 @@
+#include "SecsRollback.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace secs
+{
+
+// A chunk copied by Archetype::copyChunk into the arena, destroyed with its archetype's lifecycle helpers
+struct Rollback::ChunkCopy {
+    const Archetype* archetype = nullptr;
+    ChunkArena* arena = nullptr;
+    uint8_t* memory = nullptr;
+    size_t rows = 0; // Set once the values are in, so a failed copy destroys nothing
+
+    ~ChunkCopy()
+    {
+        if (!memory) return;
+        archetype->destroyChunkCopy(memory, rows);
+        arena->deallocate(memory, archetype->getChunkBytes());
+    }
+};
+
+// Entities and values of a sparse set, the values packed like the set keeps them
+struct Rollback::SparseCopy {
+    Archetype::ComponentData column;
+    std::vector<Entity> entities;
+    std::unique_ptr<uint8_t[]> values;
+
+    explicit SparseCopy(const SparseSet& set)
+        : column{ set.getComponentID(), ComponentRegistry::getSize(set.getComponentID()), 0, ComponentRegistry::getOps(set.getComponentID()) },
+          entities(set.entities(), set.entities() + set.size())
+    {
+        if (column.componentSize == 0) return;
+        values = std::make_unique<uint8_t[]>(set.size() * column.componentSize);
+        Archetype::copyValues(column, values.get(), set.valueAt(0), set.size());
+    }
+
+    ~SparseCopy()
+    {
+        if (values) Archetype::destroyValues(column, values.get(), entities.size());
+    }
+
+    // Put every entity back in set with its value, set has to be empty
+    void apply(SparseSet& set) const
+    {
+        for (size_t i = 0; i < entities.size(); ++i) {
+            uint8_t* value = static_cast<uint8_t*>(set.emplace(entities[i]));
+            if (!values) continue;
+            Archetype::destroyValues(column, value, 1);
+            Archetype::copyValues(column, value, values.get() + i * column.componentSize, 1);
+        }
+    }
+};
+
+struct Rollback::Frame {
+    uint64_t frame = 0;
+    uint32_t tick  = 0; // What the capture closed, anything written later is newer
+
+    struct ArchetypeCopy {
+        size_t count = 0;
+        std::vector<std::shared_ptr<const ChunkCopy>> chunks;
+    };
+    std::vector<ArchetypeCopy> archetypes; // Indexed like World::archetypeList was at capture
+
+    std::vector<std::shared_ptr<const std::vector<Record>>> records; // RECORD_PAGE records per page
+    size_t recordCount = 0;
+    std::vector<uint32_t> freeList;
+    std::vector<std::unique_ptr<SparseCopy>> sparse;
+};
+
+Rollback::Rollback(World& world, size_t capacity)
+    : world(world), capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+Rollback::~Rollback() = default;
+
+void Rollback::checkCopyable(const World& world)
+{
+    auto check = [](int compID) {
+        const ComponentOps& ops = ComponentRegistry::getOps(compID);
+        if (!ops.trivialRelocate && !ops.copy) {
+            throw std::runtime_error("Can't copy a World holding " + ComponentRegistry::getName(compID) + ", it isn't copyable!");
+        }
+    };
+    for (const Archetype* arch : world.archetypeList) {
+        if (arch->getEntityCount() == 0) continue;
+        for (const auto& comp : arch->components) check(comp.compID);
+    }
+    for (const SparseSet* set : world.activeSparseSets) {
+        if (set->size() > 0) check(set->getComponentID());
+    }
+}
+
+void Rollback::capture(uint64_t frame)
+{
+    checkCopyable(world);
+    while (!frames.empty() && frames.back()->frame >= frame) {
+        frames.pop_back();
+    }
+    const Frame* prev = frames.empty() ? nullptr : frames.back().get();
+
+    auto next = std::make_unique<Frame>();
+    next->frame = frame;
+    next->tick  = world.advanceChangeTick();
+    copiedChunks = sharedChunks = 0;
+
+    // Chunks: shared with the previous frame when nothing moved in, out or got written since it
+    next->archetypes.resize(world.archetypeList.size());
+    for (size_t a = 0; a < world.archetypeList.size(); ++a) {
+        const Archetype* arch = world.archetypeList[a];
+        Frame::ArchetypeCopy& copy = next->archetypes[a];
+        copy.count = arch->getEntityCount();
+        const Frame::ArchetypeCopy* before = prev && a < prev->archetypes.size() ? &prev->archetypes[a] : nullptr;
+
+        const auto& chunks = arch->getChunks();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (before && i < before->chunks.size() && !arch->components.empty() && before->chunks[i]->rows == chunks[i].count) {
+                const uint32_t* ticks = arch->columnTicks(chunks[i]);
+                if (std::all_of(ticks, ticks + arch->components.size(), [prev](uint32_t tick) { return tick <= prev->tick; })) {
+                    copy.chunks.push_back(before->chunks[i]);
+                    ++sharedChunks;
+                    continue;
+                }
+            }
+            auto chunk = std::make_shared<ChunkCopy>();
+            chunk->archetype = arch;
+            chunk->arena     = &arena;
+            chunk->memory    = static_cast<uint8_t*>(arena.allocate(arch->getChunkBytes()));
+            arch->copyChunk(chunk->memory, chunks[i].memory, chunks[i].count);
+            chunk->rows = chunks[i].count;
+            copy.chunks.push_back(std::move(chunk));
+            ++copiedChunks;
+        }
+    }
+
+    // Entity table: no ticks here, so pages are compared with the previous frame's instead
+    const auto& records = world.entityRecords;
+    next->recordCount = records.size();
+    for (size_t first = 0; first < records.size(); first += RECORD_PAGE) {
+        const size_t count = std::min(RECORD_PAGE, records.size() - first);
+        const size_t page  = first / RECORD_PAGE;
+        if (prev && page < prev->records.size() && sameRecords(*prev->records[page], &records[first], count)) {
+            next->records.push_back(prev->records[page]);
+        } else {
+            next->records.push_back(std::make_shared<const std::vector<Record>>(records.begin() + first, records.begin() + first + count));
+        }
+    }
+    next->freeList = world.freeList;
+
+    for (const SparseSet* set : world.activeSparseSets) {
+        if (set->size() > 0) next->sparse.push_back(std::make_unique<SparseCopy>(*set));
+    }
+
+    frames.push_back(std::move(next));
+    if (frames.size() > capacity) {
+        frames.pop_front();
+    }
+}
+
+bool Rollback::restore(uint64_t frame)
+{
+    auto it = std::find_if(frames.begin(), frames.end(), [frame](const auto& kept) { return kept->frame == frame; });
+    if (it == frames.end()) return false;
+    frames.erase(std::next(it), frames.end());
+    const Frame& target = *frames.back();
+
+    // Indices let go of the present before the past comes back
+    world.notifyAll(HookEvent::Remove);
+
+    std::vector<const uint8_t*> blocks;
+    for (size_t a = 0; a < world.archetypeList.size(); ++a) {
+        Archetype* arch = world.archetypeList[a];
+        blocks.clear();
+        size_t count = 0;
+        if (a < target.archetypes.size()) {
+            count = target.archetypes[a].count;
+            for (const auto& chunk : target.archetypes[a].chunks) blocks.push_back(chunk->memory);
+        }
+        if (count == 0 && arch->getEntityCount() == 0) continue;
+        arch->restoreChunks(blocks, count, target.tick);
+    }
+
+    world.entityRecords.resize(target.recordCount);
+    for (size_t page = 0; page < target.records.size(); ++page) {
+        std::copy(target.records[page]->begin(), target.records[page]->end(), world.entityRecords.begin() + page * RECORD_PAGE);
+    }
+    world.freeList = target.freeList;
+
+    for (SparseSet* set : world.activeSparseSets) {
+        while (set->size() > 0) set->remove(set->entities()[set->size() - 1]);
+    }
+    for (const auto& sparse : target.sparse) {
+        sparse->apply(world.getSparseSet(sparse->column.compID));
+    }
+
+    world.notifyAll(HookEvent::Add);
+    return true;
+}
+
+bool Rollback::contains(uint64_t frame) const
+{
+    return std::any_of(frames.begin(), frames.end(), [frame](const auto& kept) { return kept->frame == frame; });
+}
+
+void Rollback::clone(const World& source, World& target)
+{
+    if (!target.entityRecords.empty()) {
+        throw std::runtime_error("Rollback::clone needs a fresh target World!");
+    }
+    checkCopyable(source);
+    target.changeTick = std::max(target.changeTick, source.changeTick);
+
+    // Same signature and shared values give the same chunk layout, so chunks go over as they are
+    std::unordered_map<const Archetype*, Archetype*> mapped;
+    std::vector<const uint8_t*> blocks;
+    for (const Archetype* arch : source.archetypeList) {
+        if (arch->getEntityCount() == 0) continue;
+        SharedKey key{};
+        for (int compID : arch->getComponentIDs()) {
+            if (ComponentRegistry::isShared(compID)) key[compID] = target.internShared(compID, arch->getSharedValue(compID));
+        }
+        Archetype* copy = target.getOrCreateArchetype(arch->getSignature(), key);
+        blocks.clear();
+        for (const auto& chunk : arch->getChunks()) blocks.push_back(chunk.memory);
+        copy->restoreChunks(blocks, arch->getEntityCount(), 0);
+        mapped.emplace(arch, copy);
+    }
+
+    target.entityRecords = source.entityRecords;
+    for (auto& record : target.entityRecords) {
+        if (record.archetype) record.archetype = mapped.at(record.archetype);
+    }
+    target.freeList = source.freeList;
+
+    for (const SparseSet* set : source.activeSparseSets) {
+        if (set->size() > 0) SparseCopy(*set).apply(target.getSparseSet(set->getComponentID()));
+    }
+    target.notifyAll(HookEvent::Add);
+}
+
+bool Rollback::sameRecords(const std::vector<Record>& page, const Record* records, size_t count)
+{
+    // Field by field, the padding would throw a memcmp off
+    return page.size() == count && std::equal(page.begin(), page.end(), records, [](const Record& a, const Record& b) {
+        return a.archetype == b.archetype && a.location.chunk == b.location.chunk
+            && a.location.row == b.location.row && a.generation == b.generation;
+    });
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "Secs.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace secs
+{
+
+/*
+    ===================
+    ROLLBACK
+    ===================
+    The last few frames of a World kept in memory, for speculative simulation: predict ahead,
+    try a what-if, then put the world back without respawning anything.
+        secs::Rollback history(world, 8);
+        history.capture(frame);          // End of every frame
+        history.restore(confirmedFrame); // Back to how it was then, the frames after it are dropped
+    - A frame is every archetype's chunks copied as they are (one memcpy each, copy-constructed for
+      components that aren't trivially copyable), plus the entity table, free list and sparse sets.
+    - A chunk whose change ticks say nothing was written since the previous capture is shared with
+      that frame instead of copied, so a frame costs what changed. Restoring skips chunks the same way.
+    - The entity table is kept in pages, pages equal to the previous frame's are shared too.
+      Sparse sets have no ticks and are copied whole each frame, they're meant to be small.
+    - Restored chunks count as written, so queries, RenderSystem and publishChanges() pick them up.
+      Hooks see a Remove for everything before a restore and an Add for everything after, indices follow.
+    - Archetypes created after a frame come back empty. Entities keep their IDs and generations.
+    - Copies come from the Rollback's own ChunkArena, not the world's.
+    Throws on capture if a component can't be copied. Expects the world idle, i.e. between frames
+    after flushCommands(). Has to go before the world does.
+*/
+class PE_API Rollback
+{
+public:
+    Rollback(World& world, size_t capacity);
+    ~Rollback();
+
+    Rollback(const Rollback&) = delete;
+    Rollback& operator=(const Rollback&) = delete;
+
+    // Keep the world as it is now as frame, dropping the oldest once capacity frames are kept.
+    // Kept frames at or after frame are replaced, e.g. when re-simulating after a restore
+    void capture(uint64_t frame);
+
+    // Put the world back the way it was at frame and drop every later one. False if frame isn't kept
+    bool restore(uint64_t frame);
+
+    bool contains(uint64_t frame) const;
+    size_t size() const { return frames.size(); }
+    size_t getCapacity() const { return capacity; }
+
+    // Chunks the last capture copied, and the ones it shared with the frame before
+    size_t getCopiedChunks() const { return copiedChunks; }
+    size_t getSharedChunks() const { return sharedChunks; }
+
+    // Copy everything in source into target, which has to be fresh (no entity ever created).
+    // Chunks go over as whole blocks; entities keep their IDs and generations, and the Add hooks
+    // of target run for what arrives. For running a speculative branch next to the real world.
+    static void clone(const World& source, World& target);
+
+private:
+    using Record = World::EntityRecord;
+    static constexpr size_t RECORD_PAGE = 1024; // Entity records per page
+
+    struct ChunkCopy;
+    struct SparseCopy;
+    struct Frame;
+
+    // Throw before anything is touched if some component of world can't be copied
+    static void checkCopyable(const World& world);
+
+    // Is the page of a kept frame the same as count records starting at records?
+    static bool sameRecords(const std::vector<Record>& page, const Record* records, size_t count);
+
+    World& world;
+    size_t capacity;
+    ChunkArena arena; // Declared before frames, so it goes after the copies in it
+    std::deque<std::unique_ptr<Frame>> frames; // Oldest first
+    size_t copiedChunks = 0;
+    size_t sharedChunks = 0;
+};
+
+}
@@ -0,0 +1,528 @@
+#include "SecsSnapshot.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+    File layout, every block starts on a BLOCK_ALIGNMENT boundary:
+        Header
+        Component table: per component { size, storage, stored, name length, name }
+        Generation of every entity slot, then the free list
+        Per archetype: { column count, shared count, entity count, component indices,
+                         per shared component { component index, value } } Entity[count] column blocks...
+        Per sparse set: { component index, entity count } Entity[count] value block
+    "stored" is false for components that aren't trivially copyable, their blocks are left out.
+    Column blocks are always whole structs, field-split columns are gathered on save and scattered on load.
+*/
+namespace secs
+{
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'E', 'C', 'S' };
+    constexpr size_t BLOCK_ALIGNMENT = 16;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t componentCount;
+        uint32_t archetypeCount;
+        uint32_t sparseCount;
+        uint32_t recordCount;
+        uint32_t freeCount;
+        uint32_t reserved;
+    };
+
+    struct ComponentHeader {
+        uint32_t size;
+        uint8_t storage;
+        uint8_t stored;
+        uint16_t nameLength;
+    };
+
+    struct ArchetypeHeader {
+        uint32_t columnCount;
+        uint32_t sharedCount; // StorageKind::Shared components, their one value follows the indices
+        uint64_t entityCount;
+    };
+
+    struct SparseHeader {
+        uint32_t component;
+        uint32_t reserved;
+        uint64_t entityCount;
+    };
+
+    // Buffered file output that knows its position, for padding
+    class Writer
+    {
+    public:
+        explicit Writer(const std::string& path)
+        {
+            out.rdbuf()->pubsetbuf(buffer.get(), BUFFER_SIZE);
+            out.open(path, std::ios::binary | std::ios::trunc);
+        }
+
+        void write(const void* data, size_t size)
+        {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            position += size;
+        }
+
+        template<typename T>
+        void write(const T& value) { write(&value, sizeof(T)); }
+
+        void align()
+        {
+            static constexpr uint8_t zeros[BLOCK_ALIGNMENT] = {};
+            write(zeros, (BLOCK_ALIGNMENT - position % BLOCK_ALIGNMENT) % BLOCK_ALIGNMENT);
+        }
+
+        bool good() { out.flush(); return out.good(); }
+
+    private:
+        static constexpr size_t BUFFER_SIZE = 1 << 20;
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(BUFFER_SIZE);
+        std::ofstream out;
+        size_t position = 0;
+    };
+
+    // Bounds-checked walk over the mapped file. Hands out pointers into the mapping, no copies.
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        const uint8_t* take(size_t bytes)
+        {
+            if (!ok || bytes > size - position) {
+                ok = false;
+                return nullptr;
+            }
+            const uint8_t* at = data + position;
+            position += bytes;
+            return at;
+        }
+
+        template<typename T>
+        bool read(T& value)
+        {
+            const uint8_t* at = take(sizeof(T));
+            if (at) std::memcpy(&value, at, sizeof(T));
+            return at != nullptr;
+        }
+
+        void align()
+        {
+            take((BLOCK_ALIGNMENT - position % BLOCK_ALIGNMENT) % BLOCK_ALIGNMENT);
+        }
+
+        bool ok = true;
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t position = 0;
+    };
+
+    // Read-only view of a whole file
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string& path)
+        {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) return;
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) length = static_cast<size_t>(fileSize.QuadPart);
+#else
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat info;
+            if (fstat(fd, &info) != 0 || info.st_size == 0) return;
+            void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) return;
+            madvise(mapped, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            view   = mapped;
+            length = static_cast<size_t>(info.st_size);
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+            if (view) UnmapViewOfFile(view);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (view) munmap(view, length);
+            if (fd >= 0) close(fd);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return static_cast<const uint8_t*>(view); }
+        size_t size() const { return length; }
+
+    private:
+#ifdef _WIN32
+        HANDLE file    = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+        void* view    = nullptr;
+        size_t length = 0;
+    };
+
+    // A component of the file, after matching it against this run's registry
+    struct FileComponent {
+        size_t size;
+        bool inFile; // Its blocks were written
+        bool copy;   // ...and this run can take the bytes as they are
+        int compID;  // -1 when dropped
+    };
+
+    struct FileArchetype {
+        Signature signature;
+        std::vector<const uint8_t*> columns; // Indexed by runtime component ID, nullptr = default-construct
+        std::vector<std::pair<int, const uint8_t*>> shared; // Runtime component ID, value bytes
+        const Entity* entities;
+        size_t count;
+    };
+
+    struct FileSparse {
+        int compID; // -1 when dropped
+        const uint8_t* values;
+        const Entity* entities;
+        size_t count;
+    };
+}
+
+bool Snapshot::Save(const World& world, const std::string& path)
+{
+    // Only components something actually uses go into the table
+    std::vector<int> fileIndex(MAX_COMPONENTS, -1);
+    std::vector<int> saved;
+    auto use = [&](int compID) {
+        if (fileIndex[compID] < 0) {
+            fileIndex[compID] = static_cast<int>(saved.size());
+            saved.push_back(compID);
+        }
+    };
+    std::vector<const Archetype*> archetypes;
+    for (const Archetype* arch : world.getArchetypeList()) {
+        if (arch->getEntityCount() == 0) continue;
+        archetypes.push_back(arch);
+        for (int compID : arch->getComponentIDs()) use(compID);
+    }
+    std::vector<const SparseSet*> sparseSets;
+    for (const SparseSet* set : world.activeSparseSets) {
+        if (set->size() == 0) continue;
+        sparseSets.push_back(set);
+        use(set->getComponentID());
+    }
+    auto isStored = [](int compID) { return ComponentRegistry::getOps(compID).trivialRelocate; };
+
+    Writer out(path);
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version        = VERSION;
+    header.componentCount = static_cast<uint32_t>(saved.size());
+    header.archetypeCount = static_cast<uint32_t>(archetypes.size());
+    header.sparseCount    = static_cast<uint32_t>(sparseSets.size());
+    header.recordCount    = static_cast<uint32_t>(world.entityRecords.size());
+    header.freeCount      = static_cast<uint32_t>(world.freeList.size());
+    out.write(header);
+
+    for (int compID : saved) {
+        const std::string& name = ComponentRegistry::getName(compID);
+        ComponentHeader comp{};
+        comp.size       = static_cast<uint32_t>(ComponentRegistry::getSize(compID));
+        comp.storage    = static_cast<uint8_t>(ComponentRegistry::getStorage(compID));
+        comp.stored     = isStored(compID) ? 1 : 0;
+        comp.nameLength = static_cast<uint16_t>(name.size());
+        out.write(comp);
+        out.write(name.data(), name.size());
+    }
+
+    out.align();
+    for (const auto& record : world.entityRecords) {
+        out.write(record.generation);
+    }
+    out.write(world.freeList.data(), world.freeList.size() * sizeof(uint32_t));
+
+    std::vector<uint8_t> scratch; // A chunk's worth of split rows as whole structs
+    for (const Archetype* arch : archetypes) {
+        out.align();
+        ArchetypeHeader block{};
+        block.columnCount = static_cast<uint32_t>(arch->components.size());
+        block.sharedCount = static_cast<uint32_t>(arch->getComponentIDs().size() - arch->components.size());
+        block.entityCount = arch->getEntityCount();
+        out.write(block);
+        for (const auto& comp : arch->components) {
+            out.write(static_cast<uint32_t>(fileIndex[comp.compID]));
+        }
+        for (int compID : arch->getComponentIDs()) {
+            if (!ComponentRegistry::isShared(compID)) continue;
+            out.write(static_cast<uint32_t>(fileIndex[compID]));
+            out.write(arch->getSharedValue(compID), ComponentRegistry::getSize(compID));
+        }
+
+        out.align();
+        for (const auto& chunk : arch->getChunks()) {
+            out.write(chunk.entities(), chunk.count * sizeof(Entity));
+        }
+        for (const auto& comp : arch->components) {
+            if (!isStored(comp.compID)) continue;
+            out.align();
+            for (const auto& chunk : arch->getChunks()) {
+                if (comp.split) {
+                    scratch.resize(chunk.count * comp.componentSize);
+                    Archetype::gatherRows(comp, chunk.column(comp), arch->getChunkCapacity(), 0, scratch.data(), chunk.count);
+                    out.write(scratch.data(), scratch.size());
+                } else {
+                    out.write(chunk.column(comp), chunk.count * comp.componentSize);
+                }
+            }
+        }
+    }
+
+    for (const SparseSet* set : sparseSets) {
+        out.align();
+        SparseHeader block{};
+        block.component   = static_cast<uint32_t>(fileIndex[set->getComponentID()]);
+        block.entityCount = set->size();
+        out.write(block);
+        out.align();
+        out.write(set->entities(), set->size() * sizeof(Entity));
+        if (isStored(set->getComponentID())) {
+            out.align();
+            out.write(set->valueAt(0), set->size() * ComponentRegistry::getSize(set->getComponentID()));
+        }
+    }
+
+    if (!out.good()) {
+        std::cerr << "Snapshot: failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::Load(World& world, const std::string& path)
+{
+    if (!world.entityRecords.empty()) {
+        throw std::runtime_error("Snapshot::Load needs a fresh World!");
+    }
+
+    MappedFile file(path);
+    if (!file.data()) {
+        std::cerr << "Snapshot: can't open " << path << std::endl;
+        return false;
+    }
+    auto corrupt = [&]() {
+        std::cerr << "Snapshot: " << path << " is truncated or corrupt" << std::endl;
+        return false;
+    };
+
+    // Pass 1: walk and check the whole file, resolving components by name
+    Reader in(file.data(), file.size());
+    Header header;
+    if (!in.read(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        std::cerr << "Snapshot: " << path << " is not a snapshot" << std::endl;
+        return false;
+    }
+    if (header.version != VERSION) {
+        std::cerr << "Snapshot: " << path << " is version " << header.version << ", expected " << VERSION << std::endl;
+        return false;
+    }
+
+    std::vector<FileComponent> components;
+    for (uint32_t i = 0; i < header.componentCount; ++i) {
+        ComponentHeader comp;
+        if (!in.read(comp)) return corrupt();
+        const uint8_t* name = in.take(comp.nameLength);
+        if (!name) return corrupt();
+
+        std::string compName(reinterpret_cast<const char*>(name), comp.nameLength);
+        int compID = ComponentRegistry::findID(compName);
+        const char* dropped = nullptr;
+        if (compID < 0) {
+            dropped = "isn't registered";
+        } else if (ComponentRegistry::getSize(compID) != comp.size) {
+            dropped = "changed size";
+        } else if (static_cast<uint8_t>(ComponentRegistry::getStorage(compID)) != comp.storage) {
+            dropped = "changed storage kind";
+        }
+        if (dropped) {
+            std::cout << "Snapshot: dropping " << compName << ", it " << dropped << std::endl;
+            compID = -1;
+        }
+        FileComponent loaded{ comp.size, comp.stored != 0, false, compID };
+        if (compID >= 0 && loaded.inFile) {
+            // A type that stopped being trivially copyable can't take the bytes any more
+            loaded.copy = ComponentRegistry::getOps(compID).trivialRelocate;
+            if (!loaded.copy) {
+                std::cout << "Snapshot: " << compName << " isn't trivially copyable any more, loading defaults" << std::endl;
+            }
+        }
+        components.push_back(loaded);
+    }
+
+    in.align();
+    const uint8_t* generations = in.take(header.recordCount * sizeof(uint32_t));
+    const uint8_t* freeList    = in.take(header.freeCount * sizeof(uint32_t));
+    if (!in.ok) return corrupt();
+
+    // Every slot has to end up either free or holding exactly one entity with its own generation
+    enum : uint8_t { UNCLAIMED, FREE, ALIVE };
+    std::vector<uint8_t> slots(header.recordCount, UNCLAIMED);
+    auto matches = [&](Entity e) {
+        uint32_t generation;
+        std::memcpy(&generation, generations + e.id * sizeof(uint32_t), sizeof(uint32_t));
+        return generation == e.generation;
+    };
+    for (uint32_t i = 0; i < header.freeCount; ++i) {
+        uint32_t id;
+        std::memcpy(&id, freeList + i * sizeof(uint32_t), sizeof(uint32_t));
+        if (id >= header.recordCount || slots[id] != UNCLAIMED) return corrupt();
+        slots[id] = FREE;
+    }
+
+    std::vector<FileArchetype> archetypes;
+    for (uint32_t a = 0; a < header.archetypeCount; ++a) {
+        in.align();
+        ArchetypeHeader block;
+        if (!in.read(block) || block.entityCount > file.size()) return corrupt();
+        const uint8_t* indices = in.take(block.columnCount * sizeof(uint32_t));
+        FileArchetype arch{};
+        for (uint32_t s = 0; s < block.sharedCount; ++s) {
+            uint32_t index;
+            if (!in.read(index) || index >= components.size()) return corrupt();
+            const FileComponent& comp = components[index];
+            const uint8_t* value = in.take(comp.size);
+            if (!in.ok) return corrupt();
+            if (comp.compID >= 0) {
+                arch.signature.set(comp.compID);
+                arch.shared.emplace_back(comp.compID, value);
+            }
+        }
+        in.align();
+        const uint8_t* entities = in.take(block.entityCount * sizeof(Entity));
+        if (!in.ok) return corrupt();
+
+        arch.columns.assign(MAX_COMPONENTS, nullptr);
+        arch.entities = reinterpret_cast<const Entity*>(entities);
+        arch.count    = block.entityCount;
+        for (size_t i = 0; i < arch.count; ++i) {
+            Entity e = arch.entities[i];
+            if (e.id >= header.recordCount || slots[e.id] != UNCLAIMED || !matches(e)) return corrupt();
+            slots[e.id] = ALIVE;
+        }
+        for (uint32_t c = 0; c < block.columnCount; ++c) {
+            uint32_t index;
+            std::memcpy(&index, indices + c * sizeof(uint32_t), sizeof(uint32_t));
+            if (index >= components.size()) return corrupt();
+            const FileComponent& comp = components[index];
+            if (comp.compID >= 0) {
+                arch.signature.set(comp.compID);
+            }
+            if (comp.inFile) {
+                in.align();
+                const uint8_t* column = in.take(comp.size * arch.count);
+                if (!in.ok) return corrupt();
+                if (comp.copy) arch.columns[comp.compID] = column;
+            }
+        }
+        archetypes.push_back(std::move(arch));
+    }
+
+    std::vector<FileSparse> sparseSets;
+    for (uint32_t s = 0; s < header.sparseCount; ++s) {
+        in.align();
+        SparseHeader block;
+        if (!in.read(block) || block.component >= components.size() || block.entityCount > file.size()) return corrupt();
+        const FileComponent& comp = components[block.component];
+        in.align();
+        FileSparse set{ comp.compID, nullptr, reinterpret_cast<const Entity*>(in.take(block.entityCount * sizeof(Entity))), block.entityCount };
+        if (comp.inFile) {
+            in.align();
+            const uint8_t* values = in.take(comp.size * set.count);
+            if (comp.copy) set.values = values;
+        }
+        if (!in.ok) return corrupt();
+        for (size_t i = 0; i < set.count; ++i) {
+            // Sparse components belong to entities that live in some archetype
+            Entity e = set.entities[i];
+            if (e.id >= header.recordCount || slots[e.id] != ALIVE || !matches(e)) return corrupt();
+        }
+        sparseSets.push_back(set);
+    }
+    if (std::find(slots.begin(), slots.end(), UNCLAIMED) != slots.end()) return corrupt();
+
+    // Pass 2: apply. Slots first, so entity handles keep their IDs and generations
+    world.entityRecords.resize(header.recordCount);
+    for (uint32_t id = 0; id < header.recordCount; ++id) {
+        std::memcpy(&world.entityRecords[id].generation, generations + id * sizeof(uint32_t), sizeof(uint32_t));
+    }
+    world.freeList.resize(header.freeCount);
+    if (header.freeCount > 0) {
+        std::memcpy(world.freeList.data(), freeList, header.freeCount * sizeof(uint32_t));
+    }
+
+    // Whole column blocks per chunk, straight out of the mapping
+    for (const FileArchetype& source : archetypes) {
+        SharedKey key{};
+        for (const auto& [compID, value] : source.shared) {
+            key[compID] = world.internShared(compID, value);
+        }
+        Archetype* arch = world.getOrCreateArchetype(source.signature, key);
+        EntityLocation first = arch->appendRows(source.entities, source.count,
+            [&](Archetype::Chunk& chunk, size_t row, size_t n, size_t placed) {
+                for (const auto& comp : arch->components) {
+                    const uint8_t* src = source.columns[comp.compID];
+                    if (src) {
+                        Archetype::scatterRows(comp, chunk.column(comp), arch->getChunkCapacity(), row, src + placed * comp.componentSize, n);
+                    } else {
+                        Archetype::constructRows(comp, chunk.column(comp), arch->getChunkCapacity(), row, n);
+                    }
+                }
+            });
+        for (size_t i = 0; i < source.count; ++i) {
+            auto& record = world.entityRecords[source.entities[i].id];
+            record.archetype = arch;
+            record.location  = arch->advance(first, i);
+        }
+    }
+
+    for (const FileSparse& source : sparseSets) {
+        if (source.compID < 0) continue;
+        SparseSet& set = world.getSparseSet(source.compID);
+        const size_t size = ComponentRegistry::getSize(source.compID);
+        for (size_t i = 0; i < source.count; ++i) {
+            void* value = set.emplace(source.entities[i]);
+            if (source.values) std::memcpy(value, source.values + i * size, size);
+        }
+    }
+    // Indices and the like hear about the restored entities like about any others
+    world.notifyAll(HookEvent::Add);
+    return true;
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Secs.h"
+
+#include <string>
+
+namespace secs
+{
+
+/*
+    ===================
+    SNAPSHOT
+    ===================
+    Binary dump of a World that loads back with bulk copies instead of spawning entity by entity.
+    - Each archetype is written as its entity table followed by one contiguous block per column,
+      the bytes exactly as they sit in the chunks. Sparse sets are written the same way,
+      shared components once per archetype.
+    - Components are identified by their registered name. On load they are remapped to whatever
+      IDs this run handed out; ones that are missing, changed size or switched storage kind are dropped.
+    - Only trivially copyable components are stored. Anything else (std::string and friends)
+      comes back default-constructed.
+    - Entity slots keep their IDs and generations, so handles stored inside components stay valid.
+    - The loader maps the file into memory and copies columns straight out of the mapping.
+    Both sides expect the world to be idle, i.e. between frames after flushCommands().
+*/
+class PE_API Snapshot
+{
+public:
+    // Write world to path. False if the file couldn't be written.
+    static bool Save(const World& world, const std::string& path);
+
+    // Restore path into world, which has to be fresh (no entity ever created).
+    // The whole file is checked before anything is applied, so a missing, foreign or truncated
+    // file returns false and leaves world untouched. Add hooks run for everything restored.
+    static bool Load(World& world, const std::string& path);
+
+    // Bumped whenever the file layout changes, files with another version are refused
+    static constexpr uint32_t VERSION = 2;
+};
+
+}
@@ -0,0 +1,1290 @@
+#include "SecsTests.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <ostream>
+#include "Secs.h"
+#include "SystemScheduler.h"
+#include "SecsSnapshot.h"
+#include "SecsIndex.h"
+#include "SecsRollback.h"
+#include "systems/TransformSystem.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace
+{
+    struct TestPosition
+    {
+        float x, y, z;
+    };
+
+    struct TestVelocity
+    {
+        float dx, dy, dz;
+    };
+
+    // Owns heap memory and counts live instances, so raw byte copies show up as leaks or double frees
+    struct TestLabel
+    {
+        static inline int live = 0;
+        std::string text = "a label long enough to skip the small string buffer";
+
+        TestLabel() { ++live; }
+        TestLabel(const TestLabel& other) : text(other.text) { ++live; }
+        TestLabel(TestLabel&& other) noexcept : text(std::move(other.text)) { ++live; }
+        TestLabel& operator=(const TestLabel&) = default;
+        TestLabel& operator=(TestLabel&&) noexcept = default;
+        ~TestLabel() { --live; }
+    };
+
+    // Toggled often, lives in a sparse set
+    struct TestSelected
+    {
+        int order = 0;
+    };
+
+    // Zero-size tags, one in each storage
+    struct TestHidden
+    {
+    };
+
+    struct TestStatic
+    {
+    };
+
+    // One value per archetype, like a mesh handle
+    struct TestMaterialId
+    {
+        int id = 0;
+    };
+
+    // Stored as one array per field
+    struct TestSpin
+    {
+        float angle = 0.0f;
+        float rate  = 1.0f;
+        int turns   = 0;
+    };
+}
+
+template<>
+struct secs::SplitFields<TestSpin>
+{
+    static constexpr auto members = std::make_tuple(&TestSpin::angle, &TestSpin::rate, &TestSpin::turns);
+};
+
+namespace
+{
+
+    // Arena that counts chunks handed back
+    struct CountingArena : secs::ChunkArena
+    {
+        static inline size_t returned = 0;
+        using secs::ChunkArena::ChunkArena;
+        void deallocate(void* ptr, size_t bytes) override
+        {
+            ++returned;
+            secs::ChunkArena::deallocate(ptr, bytes);
+        }
+    };
+
+    void RegisterTestComponents()
+    {
+        secs::ComponentRegistry::registerType<TestPosition>("TestPosition");
+        secs::ComponentRegistry::registerType<TestVelocity>("TestVelocity");
+        secs::ComponentRegistry::registerType<TestLabel>("TestLabel");
+        secs::ComponentRegistry::registerType<TestSelected>("TestSelected", secs::StorageKind::Sparse);
+        secs::ComponentRegistry::registerType<TestHidden>("TestHidden", secs::StorageKind::Sparse);
+        secs::ComponentRegistry::registerType<TestStatic>("TestStatic");
+        secs::ComponentRegistry::registerType<TestMaterialId>("TestMaterialId", secs::StorageKind::Shared);
+        secs::ComponentRegistry::registerType<TestSpin>("TestSpin");
+    }
+}
+
+void SecsTests::TestAddRemoveComponent()
+{
+    secs::World world;
+    secs::Entity e = secs::EntityBuilder(world)
+                     .createEntity()
+                     .set(TestPosition{1.0f, 2.0f, 3.0f})
+                     .build();
+    world.addComponent(e, TestVelocity{4.0f, 5.0f, 6.0f});
+    world.removeComponent<TestVelocity>(e);
+
+    auto* pos = world.getComponent<TestPosition>(e);
+    if (pos && pos->x == 1.0f && pos->z == 3.0f && !world.getComponent<TestVelocity>(e)) {
+        std::cout << "TestAddRemoveComponent passed.\n";
+    } else {
+        std::cerr << "TestAddRemoveComponent failed.\n";
+    }
+}
+
+void SecsTests::TestTransitionEdgesCached()
+{
+    secs::World world;
+    for (int i = 0; i < 10; ++i)
+    {
+        secs::EntityBuilder(world)
+            .createEntity()
+            .set(TestPosition{})
+            .set(TestVelocity{})
+            .build();
+    }
+
+    // empty -> {Position} -> {Position, Velocity}, nothing else should ever get created
+    if (world.getArchetypeList().size() == 3) {
+        std::cout << "TestTransitionEdgesCached passed.\n";
+    } else {
+        std::cerr << "TestTransitionEdgesCached failed. archetypes: " << world.getArchetypeList().size() << std::endl;
+    }
+}
+
+void SecsTests::TestChunkSwapAndPop()
+{
+    secs::World world;
+    std::vector<secs::Entity> entities;
+    // Enough rows to spill over several chunks
+    for (int i = 0; i < 5000; ++i)
+    {
+        entities.push_back(secs::EntityBuilder(world)
+                           .createEntity()
+                           .set(TestPosition{static_cast<float>(i), 0.0f, 0.0f})
+                           .build());
+    }
+    // Punch holes all over, swap-and-pop pulls rows back across chunk boundaries
+    for (int i = 0; i < 5000; i += 3)
+    {
+        world.destroyEntity(entities[i]);
+    }
+
+    bool ok = true;
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto* pos = world.getComponent<TestPosition>(entities[i]);
+        bool shouldExist = i % 3 != 0;
+        if ((pos != nullptr) != shouldExist || (pos && pos->x != static_cast<float>(i)))
+        {
+            ok = false;
+        }
+    }
+
+    size_t visited = 0;
+    secs::queryChunks<TestPosition>(world, [&](const secs::Entity*, TestPosition*, size_t count)
+    {
+        visited += count;
+    });
+
+    if (ok && visited == 5000 - 1667) {
+        std::cout << "TestChunkSwapAndPop passed.\n";
+    } else {
+        std::cerr << "TestChunkSwapAndPop failed. visited: " << visited << std::endl;
+    }
+}
+
+void SecsTests::TestStaleHandleAfterReuse()
+{
+    secs::World world;
+    secs::Entity first = secs::EntityBuilder(world)
+                         .createEntity()
+                         .set(TestPosition{1.0f, 0.0f, 0.0f})
+                         .build();
+    world.destroyEntity(first);
+    secs::Entity second = secs::EntityBuilder(world)
+                          .createEntity()
+                          .set(TestPosition{2.0f, 0.0f, 0.0f})
+                          .build();
+
+    // Same slot, new generation. The old handle must not see the new entity
+    bool reused = first.id == second.id && first.generation != second.generation;
+    if (reused && !world.isAlive(first) && !world.getComponent<TestPosition>(first)
+        && world.getComponent<TestPosition>(second)->x == 2.0f && world.getEntityCount() == 1) {
+        std::cout << "TestStaleHandleAfterReuse passed.\n";
+    } else {
+        std::cerr << "TestStaleHandleAfterReuse failed.\n";
+    }
+}
+
+void SecsTests::TestSchedulerStages()
+{
+    secs::World world;
+    for (int i = 0; i < 100; ++i) {
+        secs::EntityBuilder(world)
+            .createEntity()
+            .set(TestPosition{0.0f, 0.0f, 0.0f})
+            .set(TestVelocity{1.0f, 0.0f, 0.0f})
+            .build();
+    }
+
+    float positionSum = 0.0f;
+    std::vector<secs::System> systems;
+    // Writes position
+    systems.push_back(secs::makeSystem<TestPosition>("Move",
+        [](const secs::Entity*, TestPosition* positions, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) positions[i].x += 1.0f;
+        }));
+    // Only reads velocity, can run next to Move
+    systems.push_back(secs::makeSystem<const TestVelocity>("ReadVelocity",
+        [](const secs::Entity*, const TestVelocity*, size_t) {}));
+    // Reads position, has to wait for Move
+    systems.push_back(secs::makeSystem<const TestPosition>("SumPosition",
+        [&positionSum](const secs::Entity*, const TestPosition* positions, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) positionSum += positions[i].x;
+        }));
+    // Writes velocity, has to wait for ReadVelocity
+    systems.push_back(secs::makeSystem<TestVelocity>("Damp",
+        [](const secs::Entity*, TestVelocity* velocities, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) velocities[i].dx *= 0.5f;
+        }));
+
+    SystemScheduler scheduler;
+    scheduler.Run(systems, world);
+
+    const auto& timeline = scheduler.GetTimeline();
+    bool staged = scheduler.GetStageCount() == 2
+        && timeline[0].stage == 0 && timeline[1].stage == 0
+        && timeline[2].stage == 1 && timeline[3].stage == 1;
+    if (staged && positionSum == 100.0f) {
+        std::cout << "TestSchedulerStages passed.\n";
+    } else {
+        std::cerr << "TestSchedulerStages failed. stages: " << scheduler.GetStageCount()
+                  << " sum: " << positionSum << std::endl;
+    }
+}
+
+void SecsTests::TestDeferredCommands()
+{
+    secs::World world;
+    for (int i = 0; i < 1000; ++i) {
+        secs::EntityBuilder(world)
+            .createEntity()
+            .set(TestPosition{static_cast<float>(i), 0.0f, 0.0f})
+            .build();
+    }
+
+    // Structural changes from inside a parallel iteration: odd ones get a velocity, even ones
+    // are destroyed and replaced by a new entity
+    world.query<TestPosition>().forEachChunkParallel(
+        [&world](const secs::Entity* ents, TestPosition* positions, size_t count)
+        {
+            secs::CommandBuffer& commands = world.commands();
+            for (size_t i = 0; i < count; ++i) {
+                if (static_cast<int>(positions[i].x) % 2 == 0) {
+                    commands.destroyEntity(ents[i]);
+                    secs::Entity spawned = commands.createEntity();
+                    commands.addComponent(spawned, TestVelocity{-1.0f, 0.0f, 0.0f});
+                } else {
+                    commands.addComponent(ents[i], TestVelocity{positions[i].x, 0.0f, 0.0f});
+                }
+            }
+        });
+    bool untouched = world.getEntityCount() == 1000 && world.query<TestVelocity>().count() == 0;
+    world.flushCommands();
+
+    size_t moved = 0, spawned = 0;
+    bool valuesOk = true;
+    world.query<TestVelocity>().forEachChunk([&](const secs::Entity* ents, TestVelocity* velocities, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            TestPosition* pos = world.getComponent<TestPosition>(ents[i]);
+            if (pos) {
+                ++moved;
+                valuesOk &= pos->x == velocities[i].dx;
+            } else {
+                ++spawned;
+                valuesOk &= velocities[i].dx == -1.0f;
+            }
+        }
+    });
+
+    if (untouched && valuesOk && moved == 500 && spawned == 500 && world.getEntityCount() == 1000) {
+        std::cout << "TestDeferredCommands passed.\n";
+    } else {
+        std::cerr << "TestDeferredCommands failed. moved: " << moved << " spawned: " << spawned << std::endl;
+    }
+}
+
+void SecsTests::TestCommandOrder()
+{
+    secs::World world;
+    std::vector<secs::Entity> entities = world.createEntities(5000, TestPosition{});
+    for (size_t i = 0; i < entities.size(); ++i) {
+        world.getComponent<TestPosition>(entities[i])->x = static_cast<float>(i);
+    }
+    const secs::Entity target = entities[0];
+
+    // Same stage, so the two run on whichever threads. Spawn tags one entity per chunk from a
+    // parallel query, Tail spawns one more; both set TestSelected on target
+    secs::Entity tail{};
+    std::vector<secs::System> systems;
+    systems.emplace_back("Spawn", secs::Signature{}, secs::Signature{}, [&](secs::World& w)
+    {
+        w.commands().addComponent(target, TestSelected{ 1 });
+        w.query<const TestPosition>().forEachChunkParallel([&w](const secs::Entity*, const TestPosition* positions, size_t)
+        {
+            secs::CommandBuffer& commands = w.commands();
+            commands.addComponent(commands.createEntity(), TestVelocity{ positions[0].x, 0.0f, 0.0f });
+        });
+    });
+    systems.emplace_back("Tail", secs::Signature{}, secs::Signature{}, [&](secs::World& w)
+    {
+        tail = w.commands().createEntity();
+        w.commands().addComponent(tail, TestVelocity{ -1.0f, 0.0f, 0.0f });
+        w.commands().addComponent(target, TestSelected{ 2 });
+    });
+
+    SystemScheduler scheduler;
+    scheduler.Run(systems, world);
+    bool pending = !world.isAlive(tail);
+    world.flushCommands();
+    tail = world.resolve(tail);
+
+    // IDs go out in schedule order, and inside Spawn in chunk order
+    std::vector<std::pair<uint32_t, float>> spawned;
+    world.query<const TestVelocity>().forEachChunk([&](const secs::Entity* ents, const TestVelocity* velocities, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) spawned.emplace_back(ents[i].id, velocities[i].dx);
+    });
+    std::sort(spawned.begin(), spawned.end());
+    bool ordered = spawned.size() > 2 && spawned.back().second == -1.0f;
+    for (size_t i = 1; ordered && i + 1 < spawned.size(); ++i) {
+        ordered = spawned[i - 1].second < spawned[i].second;
+    }
+
+    const TestSelected* selected = world.getComponent<const TestSelected>(target);
+    if (pending && ordered && selected && selected->order == 2 && world.getComponent<const TestVelocity>(tail)
+        && world.getComponent<const TestVelocity>(tail)->dx == -1.0f && scheduler.GetStageCount() == 1) {
+        std::cout << "TestCommandOrder passed.\n";
+    } else {
+        std::cerr << "TestCommandOrder failed. spawned: " << spawned.size() << " ordered: " << ordered << std::endl;
+    }
+}
+
+void SecsTests::TestBulkCreateDestroy()
+{
+    secs::World world;
+    std::vector<secs::Entity> entities = world.createEntities(5000, TestPosition{1.0f, 2.0f, 3.0f}, TestVelocity{});
+    for (size_t i = 0; i < entities.size(); ++i) {
+        world.getComponent<TestPosition>(entities[i])->x = static_cast<float>(i);
+    }
+
+    // Every third one plus the whole tail, with a duplicate and a stale handle mixed in
+    std::vector<secs::Entity> doomed;
+    for (size_t i = 0; i < 4000; i += 3) doomed.push_back(entities[i]);
+    for (size_t i = 4000; i < 5000; ++i) doomed.push_back(entities[i]);
+    doomed.push_back(entities[0]);
+    doomed.push_back(secs::Entity{ entities[1].id, entities[1].generation + 1 });
+    world.destroyEntities(doomed);
+
+    bool ok = world.getEntityCount() == 4000 - 1334 && world.query<TestPosition, TestVelocity>().count() == 4000 - 1334;
+    for (size_t i = 0; i < 5000; ++i) {
+        auto* pos = world.getComponent<TestPosition>(entities[i]);
+        bool shouldExist = i < 4000 && i % 3 != 0;
+        if ((pos != nullptr) != shouldExist || (pos && (pos->x != static_cast<float>(i) || pos->z != 3.0f))) {
+            ok = false;
+        }
+    }
+
+    // Freed slots get reused by the next bulk create
+    std::vector<secs::Entity> refill = world.createEntities(10, std::vector<int>{ secs::ComponentRegistry::getID<TestPosition>() });
+    ok &= refill.front().id < 5000 && world.getComponent<TestPosition>(refill.back())->x == 0.0f;
+
+    if (ok) {
+        std::cout << "TestBulkCreateDestroy passed.\n";
+    } else {
+        std::cerr << "TestBulkCreateDestroy failed.\n";
+    }
+}
+
+void SecsTests::TestNonTrivialComponents()
+{
+    bool ok = true;
+    {
+        secs::World world;
+        std::vector<secs::Entity> entities = world.createEntities(3000, TestPosition{}, TestLabel{});
+        for (size_t i = 0; i < entities.size(); ++i) {
+            world.getComponent<TestLabel>(entities[i])->text = "label number " + std::to_string(i) + " with some padding";
+        }
+
+        // Moves in both directions, single destroys and a bulk destroy all shuffle rows around
+        for (size_t i = 0; i < entities.size(); i += 2) world.addComponent(entities[i], TestVelocity{});
+        for (size_t i = 0; i < entities.size(); i += 4) world.removeComponent<TestVelocity>(entities[i]);
+        for (size_t i = 1; i < entities.size(); i += 5) world.destroyEntity(entities[i]);
+        world.destroyEntities(std::span<const secs::Entity>(entities).subspan(2000));
+
+        for (size_t i = 0; i < 2000; ++i) {
+            auto* label = world.getComponent<TestLabel>(entities[i]);
+            bool shouldExist = i % 5 != 1;
+            if ((label != nullptr) != shouldExist
+                || (label && label->text != "label number " + std::to_string(i) + " with some padding")) {
+                ok = false;
+            }
+        }
+        world.removeComponent<TestLabel>(entities[0]);
+        ok &= TestLabel::live == 2000 - 400 - 1;
+    }
+    // World teardown destroys whatever is still alive
+    ok &= TestLabel::live == 0;
+
+    if (ok) {
+        std::cout << "TestNonTrivialComponents passed.\n";
+    } else {
+        std::cerr << "TestNonTrivialComponents failed. live: " << TestLabel::live << std::endl;
+    }
+}
+
+void SecsTests::TestChangeTicks()
+{
+    secs::World world;
+    // Several chunks worth of positions, half of them also moving
+    std::vector<secs::Entity> still  = world.createEntities(2000, TestPosition{});
+    std::vector<secs::Entity> moving = world.createEntities(2000, TestPosition{}, TestVelocity{});
+
+    auto& positions = world.query<TestPosition>();
+    auto countChanged = [&](uint32_t since)
+    {
+        size_t rows = 0;
+        positions.forEachChunkChangedSince<TestPosition>(since, [&](const secs::Entity*, TestPosition*, size_t count) { rows += count; });
+        return rows;
+    };
+
+    // Everything is new at first
+    bool ok = countChanged(0) == 4000;
+    uint32_t lastTick = world.advanceChangeTick();
+    ok &= countChanged(lastTick) == 0; // The iteration above wrote in the closed tick
+
+    // A system writing positions of the movers only, and a read-only pass over everything
+    lastTick = world.advanceChangeTick();
+    world.query<TestPosition, const TestVelocity>().forEachChunk(
+        [](const secs::Entity*, TestPosition* p, const TestVelocity*, size_t count) { for (size_t i = 0; i < count; ++i) p[i].x += 1.0f; });
+    world.query<const TestPosition>().forEachChunk([](const secs::Entity*, const TestPosition*, size_t) {});
+    size_t changedRows = 0;
+    world.query<const TestPosition>().forEachChunkChangedSince<TestPosition>(lastTick,
+        [&](const secs::Entity*, const TestPosition*, size_t count) { changedRows += count; });
+    ok &= changedRows == 2000 && !world.query<const TestVelocity>().changedSince<TestVelocity>(lastTick);
+
+    // Single writes through getComponent only flag their own chunk
+    lastTick = world.advanceChangeTick();
+    world.getComponent<const TestPosition>(still[0]);
+    ok &= !world.query<const TestPosition>().changedSince<TestPosition>(lastTick);
+    world.getComponent<TestPosition>(still[0])->y = 2.0f;
+    changedRows = 0;
+    world.query<const TestPosition>().forEachChunkChangedSince<TestPosition>(lastTick,
+        [&](const secs::Entity* ents, const TestPosition*, size_t count) { changedRows += count; ok &= ents[0] == still[0]; });
+    ok &= changedRows > 0 && changedRows < 2000;
+
+    if (ok) {
+        std::cout << "TestChangeTicks passed.\n";
+    } else {
+        std::cerr << "TestChangeTicks failed. changed rows: " << changedRows << std::endl;
+    }
+}
+
+void SecsTests::TestSparseComponents()
+{
+    secs::World world;
+    std::vector<secs::Entity> entities = world.createEntities(1000, TestPosition{}, TestStatic{});
+    for (size_t i = 0; i < entities.size(); ++i) {
+        world.getComponent<TestPosition>(entities[i])->x = static_cast<float>(i);
+    }
+    const size_t archetypesBefore = world.getArchetypeList().size();
+
+    // Toggling sparse components never moves a row or creates an archetype
+    for (size_t i = 0; i < entities.size(); i += 10) {
+        world.addComponent(entities[i], TestSelected{static_cast<int>(i)});
+        world.addComponent(entities[i], TestHidden{});
+    }
+    for (size_t i = 0; i < entities.size(); i += 20) {
+        world.removeComponent<TestHidden>(entities[i]);
+    }
+    world.commands().addComponent(entities[1], TestSelected{1});
+    world.flushCommands();
+    world.destroyEntity(entities[10]);
+
+    bool ok = world.getArchetypeList().size() == archetypesBefore
+        && secs::ComponentRegistry::getSize(secs::ComponentRegistry::getID<TestStatic>()) == 0
+        && world.getComponent<TestStatic>(entities[0]) != nullptr;
+
+    // Sparse terms filter the query, values and columns line up per entity
+    size_t selected = 0;
+    world.query<const TestPosition, TestSelected>().forEachChunk(
+        [&](const secs::Entity*, const TestPosition* positions, TestSelected* selections, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                ++selected;
+                ok &= static_cast<int>(positions[i].x) == selections[i].order;
+            }
+        });
+    const size_t hidden = world.query<const TestPosition, const TestSelected, const TestHidden>().count();
+    ok &= selected == 100 && hidden == 49 && world.query<TestSelected>().count() == 100;
+
+    // Driven by the sparse set in parallel, so rows of one chunk are written from several threads
+    const uint32_t beforeWrite = world.advanceChangeTick();
+    world.query<TestPosition, const TestSelected>().forEachChunkParallel(
+        [](const secs::Entity*, TestPosition* positions, const TestSelected*, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) positions[i].y = 1.0f;
+        });
+    ok &= world.query<const TestPosition>().changedSince<const TestPosition>(beforeWrite)
+       && world.getComponent<TestPosition>(entities[20])->y == 1.0f;
+
+    // A reused slot must not inherit the old entity's sparse components
+    secs::Entity reused = world.createEntity({ secs::ComponentRegistry::getID<TestPosition>() });
+    ok &= reused.id == entities[10].id && !world.getComponent<TestSelected>(reused);
+
+    if (ok) {
+        std::cout << "TestSparseComponents passed.\n";
+    } else {
+        std::cerr << "TestSparseComponents failed. selected: " << selected << " hidden: " << hidden << std::endl;
+    }
+}
+
+void SecsTests::TestSnapshotRoundTrip()
+{
+    using Clock = std::chrono::steady_clock;
+    auto millis = [](Clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+    };
+    const std::string path = (std::filesystem::temp_directory_path() / "secs_snapshot_test.bin").string();
+    const size_t count = 100000;
+
+    // Spawned one at a time, the way levels get built today
+    auto start = Clock::now();
+    secs::World source;
+    std::vector<secs::Entity> entities;
+    entities.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        secs::EntityBuilder builder(source);
+        builder.createEntity().set(TestPosition{ static_cast<float>(i), 1.0f, 2.0f });
+        if (i % 2 == 0) builder.set(TestVelocity{ 0.0f, static_cast<float>(i), 0.0f });
+        if (i % 100 == 0) builder.set(TestLabel{});
+        entities.push_back(builder.build());
+        if (i % 7 == 0) source.addComponent(entities.back(), TestSelected{ static_cast<int>(i) });
+    }
+    const double spawnMs = millis(start);
+
+    // Leave some holes so the free list and generations have something to carry
+    std::vector<secs::Entity> doomed;
+    for (size_t i = 0; i < count; i += 10) doomed.push_back(entities[i]);
+    source.destroyEntities(doomed);
+
+    start = Clock::now();
+    bool ok = secs::Snapshot::Save(source, path);
+    const double saveMs = millis(start);
+
+    start = Clock::now();
+    secs::World loaded;
+    ok &= secs::Snapshot::Load(loaded, path);
+    const double loadMs = millis(start);
+
+    ok &= loaded.getEntityCount() == source.getEntityCount()
+       && loaded.query<const TestSelected>().count() == source.query<const TestSelected>().count();
+    for (size_t i = 0; i < count; ++i) {
+        secs::Entity e = entities[i];
+        auto* pos = loaded.getComponent<const TestPosition>(e);
+        if (i % 10 == 0) {
+            ok &= pos == nullptr; // Stale handles stay stale
+            continue;
+        }
+        auto* vel      = loaded.getComponent<const TestVelocity>(e);
+        auto* label    = loaded.getComponent<const TestLabel>(e);
+        auto* selected = loaded.getComponent<const TestSelected>(e);
+        ok &= pos && pos->x == static_cast<float>(i) && pos->z == 2.0f
+           && (vel != nullptr) == (i % 2 == 0) && (!vel || vel->dy == static_cast<float>(i))
+           && (label != nullptr) == (i % 100 == 0) && (!label || label->text == TestLabel{}.text)
+           && (selected != nullptr) == (i % 7 == 0) && (!selected || selected->order == static_cast<int>(i));
+    }
+    // Freed slots come back in the same order as in the source
+    ok &= loaded.createEntity({}).id == source.createEntity({}).id;
+
+    // A truncated file is refused without touching the world
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    secs::World truncated;
+    ok &= !secs::Snapshot::Load(truncated, path) && truncated.getEntityCount() == 0;
+    std::filesystem::remove(path);
+
+    if (ok) {
+        std::cout << "TestSnapshotRoundTrip passed. " << count << " entities, spawn " << spawnMs
+                  << " ms, save " << saveMs << " ms, load " << loadMs << " ms\n";
+    } else {
+        std::cerr << "TestSnapshotRoundTrip failed.\n";
+    }
+}
+
+void SecsTests::TestTransformHierarchy()
+{
+    TransformHierarchy::RegisterComponents();
+    secs::World world;
+    TransformHierarchy hierarchy;
+    uint32_t lastTick = 0;
+    // What RenderSystem does every frame: locals for written chunks, then the hierarchy on top
+    auto frame = [&]()
+    {
+        world.query<Transform>().forEachChunkChangedSince<Transform>(lastTick, [](const secs::Entity*, Transform* t, size_t count) {
+            for (size_t i = 0; i < count; ++i) t[i].UpdateModelMatrix();
+        });
+        hierarchy.Propagate(world, lastTick);
+        lastTick = world.advanceChangeTick();
+    };
+    auto placed = [](const glm::vec3& position) { Transform t; t.position = position; return t; };
+    auto worldPosition = [&](secs::Entity e) { return glm::vec3(world.getComponent<const Transform>(e)->model[3]); };
+
+    // Two trees, roots in different archetypes so their chunks change independently.
+    // Children are created before their parents to make sure order comes from depth, not creation
+    secs::Entity rootA = world.createEntities(1, placed({ 10.0f, 0.0f, 0.0f }))[0];
+    secs::Entity rootB = world.createEntities(1, placed({ 0.0f, 10.0f, 0.0f }), TestVelocity{})[0];
+    std::vector<secs::Entity> grandchildren = world.createEntities(300, placed({ 0.0f, 0.0f, 1.0f }), Parent{});
+    std::vector<secs::Entity> children = world.createEntities(3, placed({ 1.0f, 0.0f, 0.0f }), Parent{ rootA });
+    for (size_t i = 0; i < grandchildren.size(); ++i) {
+        world.getComponent<Parent>(grandchildren[i])->entity = children[i % children.size()];
+    }
+    secs::Entity childB = world.createEntities(1, placed({ 0.0f, 1.0f, 0.0f }), Parent{ rootB })[0];
+
+    frame();
+    bool ok = hierarchy.GetNodeCount() == 304 && hierarchy.GetDepthCount() == 2
+           && worldPosition(grandchildren[7]) == glm::vec3(11.0f, 0.0f, 1.0f)
+           && worldPosition(childB) == glm::vec3(0.0f, 11.0f, 0.0f);
+
+    // Nothing written, nothing recomputed
+    frame();
+    ok &= hierarchy.GetUpdatedCount() == 0;
+
+    // Moving root A only recomputes its own subtree
+    world.getComponent<Transform>(rootA)->position.x = 20.0f;
+    frame();
+    ok &= hierarchy.GetUpdatedCount() == 303 && worldPosition(grandchildren[7]) == glm::vec3(21.0f, 0.0f, 1.0f);
+
+    // Re-parenting rebuilds the order and picks up the new parent
+    world.getComponent<Parent>(children[0])->entity = childB;
+    frame();
+    ok &= hierarchy.GetDepthCount() == 3 && worldPosition(grandchildren[0]) == glm::vec3(1.0f, 11.0f, 1.0f);
+
+    // A dead parent leaves its children with their local matrix
+    world.destroyEntity(rootB);
+    frame();
+    ok &= worldPosition(childB) == glm::vec3(0.0f, 1.0f, 0.0f) && worldPosition(grandchildren[0]) == glm::vec3(1.0f, 1.0f, 1.0f);
+    frame();
+    ok &= hierarchy.GetUpdatedCount() == 0;
+
+    if (ok) {
+        std::cout << "TestTransformHierarchy passed.\n";
+    } else {
+        std::cerr << "TestTransformHierarchy failed.\n";
+    }
+}
+
+void SecsTests::TestChunkAllocator()
+{
+    bool ok = true;
+    auto aligned = [](const void* ptr) { return reinterpret_cast<uintptr_t>(ptr) % secs::COLUMN_ALIGNMENT == 0; };
+
+    // Two worlds taking turns on one pool: the second one runs on the memory the first handed back
+    secs::ChunkArena shared;
+    size_t reserved = 0;
+    {
+        secs::World first(shared);
+        first.createEntities(20000, TestPosition{}, TestVelocity{});
+        reserved = shared.getReservedBytes();
+    }
+    {
+        secs::World second(shared);
+        second.createEntities(20000, TestPosition{}, TestVelocity{});
+        ok &= reserved > 0 && shared.getReservedBytes() == reserved;
+        second.query<const TestPosition, const TestVelocity>().forEachChunk(
+            [&](const secs::Entity* ents, const TestPosition* p, const TestVelocity* v, size_t) {
+                ok &= aligned(ents) && aligned(p) && aligned(v);
+            });
+    }
+
+    // An owned allocator is dropped whole, chunks aren't handed back one by one.
+    // Huge pages are only a request, the world has to work the same either way
+    CountingArena::returned = 0;
+    {
+        secs::World world(std::make_unique<CountingArena>(true));
+        std::vector<secs::Entity> entities = world.createEntities(20000, TestPosition{ 1.0f, 2.0f, 3.0f }, TestLabel{});
+        world.destroyEntities(std::span<const secs::Entity>(entities).subspan(10000));
+        ok &= CountingArena::returned > 0 && world.getComponent<TestPosition>(entities[9999])->z == 3.0f;
+        CountingArena::returned = 0;
+    }
+    ok &= CountingArena::returned == 0 && TestLabel::live == 0;
+
+    if (ok) {
+        std::cout << "TestChunkAllocator passed.\n";
+    } else {
+        std::cerr << "TestChunkAllocator failed.\n";
+    }
+}
+
+void SecsTests::TestArchetypeStats()
+{
+    secs::World world;
+    std::vector<secs::Entity> entities = world.createEntities(1000, TestPosition{});
+    world.resetFrameStats();
+    for (size_t i = 0; i < 10; ++i) world.addComponent(entities[i], TestVelocity{});
+    world.addComponent(entities[999], TestSelected{}); // Sparse, nothing moves
+
+    const std::vector<secs::ArchetypeStats> stats = world.getArchetypeStats();
+    const secs::ArchetypeStats* positions = nullptr;
+    const secs::ArchetypeStats* moving = nullptr;
+    for (const auto& arch : stats) {
+        if (arch.signature == "TestPosition") positions = &arch;
+        if (arch.signature == "TestPosition|TestVelocity") moving = &arch;
+    }
+    bool ok = positions && moving
+           && positions->entityCount == 990 && positions->movesOut == 10 && positions->movesIn == 0
+           && moving->entityCount == 10 && moving->movesIn == 10 && moving->chunkCount == 1
+           && moving->slackRows == moving->chunkCapacity - 10
+           && moving->columns.size() == 2 && moving->columns[1].usedBytes == 10 * sizeof(TestVelocity)
+           && positions->allocatedBytes == positions->chunkCount * secs::CHUNK_SIZE;
+    const auto sparse = world.getSparseSetStats();
+    ok &= sparse.size() == 1 && sparse[0].name == "TestSelected" && sparse[0].entityCount == 1;
+
+    world.resetFrameStats();
+    for (const auto& arch : world.getArchetypeStats()) {
+        ok &= arch.movesIn == 0 && arch.movesOut == 0;
+    }
+
+    if (ok) {
+        std::cout << "TestArchetypeStats passed.\n";
+    } else {
+        std::cerr << "TestArchetypeStats failed.\n";
+    }
+}
+
+void SecsTests::TestPrefabInstantiate()
+{
+    bool ok = true;
+    {
+        secs::World world;
+        TestLabel label;
+        label.text = "prefab label, long enough to live on the heap";
+        secs::Prefab prefab = world.makePrefab(TestPosition{ 1.0f, 2.0f, 3.0f }, TestVelocity{ 0.0f, 0.0f, 9.0f }, label, TestSelected{ 7 });
+
+        // Spans several chunks and starts in the partly filled one
+        std::vector<secs::Entity> first = world.instantiate(prefab, 10);
+        std::vector<TestPosition> placements(5000);
+        for (size_t i = 0; i < placements.size(); ++i) placements[i] = { static_cast<float>(i), 0.0f, 0.0f };
+        std::vector<secs::Entity> placed = world.instantiate(prefab, std::span<const TestPosition>(placements));
+
+        ok &= first.size() == 10 && placed.size() == placements.size();
+        ok &= world.query<TestPosition, TestVelocity, TestLabel>().count() == 5010;
+        for (size_t i = 0; i < placed.size(); ++i)
+        {
+            const TestPosition* p = world.getComponent<TestPosition>(placed[i]);
+            const TestSelected* s = world.getComponent<TestSelected>(placed[i]);
+            ok &= p && p->x == static_cast<float>(i) && p->y == 0.0f;
+            ok &= world.getComponent<TestVelocity>(placed[i])->dz == 9.0f;
+            ok &= world.getComponent<TestLabel>(placed[i])->text == label.text;
+            ok &= s && s->order == 7;
+        }
+        ok &= world.getComponent<TestPosition>(first[9])->z == 3.0f;
+
+        // Overrides have to be something the prefab has, and prefabs don't cross worlds
+        bool threw = false;
+        try { world.instantiate(prefab, std::span<const TestStatic>()); } catch (const std::runtime_error&) { threw = true; }
+        ok &= threw;
+        secs::World other;
+        threw = false;
+        try { other.instantiate(prefab, 1); } catch (const std::runtime_error&) { threw = true; }
+        ok &= threw && other.query<TestPosition>().count() == 0;
+
+        // 5010 in the world, one in the prefab, one here
+        ok &= TestLabel::live == 5012;
+
+        // Moving hands the values over and leaves nothing usable behind
+        secs::Prefab moved(std::move(prefab));
+        ok &= moved.isValid() && !prefab.isValid() && TestLabel::live == 5012;
+    }
+    ok &= TestLabel::live == 0;
+
+    if (ok) {
+        std::cout << "TestPrefabInstantiate passed.\n";
+    } else {
+        std::cerr << "TestPrefabInstantiate failed.\n";
+    }
+}
+
+void SecsTests::TestQueryFilters()
+{
+    using secs::Optional;
+    using secs::With;
+    using secs::Without;
+    using secs::Changed;
+
+    secs::World world;
+    world.createEntities(100, TestPosition{});
+    std::vector<secs::Entity> moving = world.createEntities(100, TestPosition{}, TestVelocity{ 1.0f, 0.0f, 0.0f });
+    world.createEntities(100, TestPosition{}, TestStatic{});
+    for (size_t i = 0; i < 5; ++i) world.addComponent(moving[i], TestSelected{});
+
+    // Optional hands out nullptr for whole chunks, Without drops the static archetype up front
+    size_t withVelocity = 0, withoutVelocity = 0;
+    auto& dynamic = world.query<const TestPosition, Optional<const TestVelocity>, Without<TestStatic>>();
+    dynamic.forEachChunk([&](const secs::Entity*, const TestPosition*, const TestVelocity* v, size_t count) {
+        (v ? withVelocity : withoutVelocity) += count;
+    });
+    bool ok = withVelocity == 100 && withoutVelocity == 100 && !dynamic.isSparseDriven();
+    ok &= world.query<const TestPosition, With<TestStatic>>().count() == 100;
+
+    // Changed skips every chunk whose column wasn't written since the tick
+    const uint32_t since = world.advanceChangeTick();
+    auto& changed = world.query<const TestPosition, Changed<TestVelocity>>();
+    ok &= changed.since(since).count() == 0;
+    world.getComponent<TestVelocity>(moving[50])->dx = 2.0f;
+    ok &= changed.since(since).count() == 100; // Chunk granularity
+    // Views of one cached query keep their own thresholds
+    auto everything = changed.since(0);
+    auto fromNow = changed.since(world.getChangeTick());
+    ok &= fromNow.count() == 0 && everything.count() == 100;
+
+    // Sparse terms are checked entity by entity, the callback doesn't notice
+    auto& unselected = world.query<const TestPosition, Without<TestSelected>>();
+    ok &= unselected.isSparseDriven() && unselected.count() == 295;
+    size_t selected = 0;
+    world.query<const TestVelocity, Optional<const TestSelected>>().forEachChunk(
+        [&](const secs::Entity*, const TestVelocity*, const TestSelected* s, size_t count) {
+            if (s) selected += count;
+        });
+    ok &= selected == 5;
+
+    // Filter terms don't count as access for the scheduler
+    const int velocityID = secs::ComponentRegistry::getID<TestVelocity>();
+    const int staticID   = secs::ComponentRegistry::getID<TestStatic>();
+    ok &= secs::detail::readMask<TestPosition, Changed<TestVelocity>, Without<TestStatic>>().test(velocityID)
+       && !secs::detail::componentMask<TestPosition, Without<TestStatic>>().test(staticID);
+
+    if (ok) {
+        std::cout << "TestQueryFilters passed.\n";
+    } else {
+        std::cerr << "TestQueryFilters failed.\n";
+    }
+}
+
+void SecsTests::TestArchetypeCompaction()
+{
+    auto arena = std::make_unique<secs::ChunkArena>(false, 256 * 1024); // Small blocks, so a despawn empties some
+    secs::ChunkArena* chunks = arena.get();
+    secs::World world(std::move(arena));
+
+    // Built up one component at a time, like EntityBuilder, leaving two empty archetypes behind
+    std::vector<secs::Entity> entities = world.createEntities(60000, std::vector<int>{});
+    for (secs::Entity e : entities) world.addComponent(e, TestPosition{});
+    for (secs::Entity e : entities) world.addComponent(e, TestVelocity{});
+    for (size_t i = 0; i < 2000; ++i) world.addComponent(entities[i], TestSelected{});
+
+    auto& positions = world.query<const TestPosition>();
+    bool ok = world.getArchetypeList().size() == 3 && positions.archetypeCount() == 1 && positions.count() == 60000;
+
+    // Walks nothing once everything's gone, picks the archetype back up when it fills again
+    const size_t reserved = chunks->getReservedBytes();
+    world.destroyEntities(std::span<const secs::Entity>(entities).subspan(10));
+    ok &= world.compact() > 0 && chunks->getReservedBytes() < reserved;
+    ok &= world.getComponent<TestPosition>(entities[9]) && world.getComponent<TestSelected>(entities[9]);
+    world.destroyEntities(std::span<const secs::Entity>(entities).first(10));
+    ok &= positions.archetypeCount() == 0 && positions.count() == 0;
+    world.compact();
+    ok &= chunks->getReservedBytes() == 0;
+
+    std::vector<secs::Entity> again = world.createEntities(100, TestPosition{ 1.0f, 2.0f, 3.0f });
+    world.addComponent(again[0], TestSelected{ 4 });
+    ok &= positions.archetypeCount() == 1 && positions.count() == 100
+       && world.getComponent<TestPosition>(again[99])->z == 3.0f
+       && world.getComponent<TestSelected>(again[0])->order == 4;
+
+    if (ok) {
+        std::cout << "TestArchetypeCompaction passed.\n";
+    } else {
+        std::cerr << "TestArchetypeCompaction failed.\n";
+    }
+}
+
+void SecsTests::TestComponentRegistry()
+{
+    struct Unregistered
+    {
+        int value;
+    };
+
+    using Registry = secs::ComponentRegistry;
+    const int position = Registry::getID<TestPosition>();
+    const int label    = Registry::getID<TestLabel>();
+    bool ok = Registry::getID<const TestPosition>() == position
+           && Registry::registerType<TestPosition>("Again") == position // Re-registering keeps the first ID and name
+           && Registry::getName(position) == "TestPosition" && Registry::findID("TestLabel") == label
+           && Registry::getSize(position) == sizeof(TestPosition) && Registry::getAlignment(label) == alignof(TestLabel)
+           && Registry::getSize(Registry::getID<TestHidden>()) == 0 && Registry::isSparse(Registry::getID<TestHidden>())
+           && !Registry::getInfo(label).ops.trivialRelocate && Registry::getInfo(position).ops.trivialRelocate;
+    ok &= !Registry::isRegistered(Registry::getCount()) && Registry::getName(-1) == "UnknownComponent" && Registry::findID("Nope") == -1;
+
+    bool threw = false;
+    try { Registry::getID<Unregistered>(); } catch (const std::runtime_error&) { threw = true; }
+    ok &= threw;
+
+    if (ok) {
+        std::cout << "TestComponentRegistry passed.\n";
+    } else {
+        std::cerr << "TestComponentRegistry failed.\n";
+    }
+}
+
+void SecsTests::TestSharedComponents()
+{
+    secs::World world;
+    // Equal values share an archetype, different ones get their own
+    std::vector<secs::Entity> red  = world.createEntities(100, TestPosition{}, TestMaterialId{ 1 });
+    std::vector<secs::Entity> blue = world.createEntities(50, TestPosition{}, TestMaterialId{ 2 });
+    secs::Archetype* redArch;
+    secs::Archetype* blueArch;
+    secs::EntityLocation loc;
+    world.locate(red[0], redArch, loc);
+    world.locate(blue[0], blueArch, loc);
+    bool ok = redArch != blueArch && redArch->getSignature() == blueArch->getSignature()
+           && redArch->components.size() == 1 && world.createEntities(1, TestPosition{}, TestMaterialId{ 1 }).size() == 1
+           && redArch->getEntityCount() == 101;
+
+    // One value per chunk instead of a column
+    size_t rows = 0;
+    int sum = 0;
+    world.query<const TestPosition, secs::Shared<TestMaterialId>>().forEachChunk(
+        [&](const secs::Entity*, const TestPosition*, const TestMaterialId* material, size_t count)
+        {
+            rows += count;
+            sum  += material->id * static_cast<int>(count);
+        });
+    ok &= rows == 151 && sum == 101 + 2 * 50;
+
+    // Setting the value moves the row, removing it leaves the table components alone
+    world.addComponent(red[0], TestMaterialId{ 2 });
+    ok &= world.getComponent<const TestMaterialId>(red[0])->id == 2 && blueArch->getEntityCount() == 51;
+    world.addComponent(red[0], TestMaterialId{ 1 });
+    world.getComponent<TestPosition>(red[1])->x = 5.0f;
+    world.removeComponent<TestMaterialId>(red[1]);
+    ok &= redArch->getEntityCount() == 100 && !world.getComponent<const TestMaterialId>(red[1])
+       && world.getComponent<TestPosition>(red[1])->x == 5.0f;
+
+    // Per-entity iteration hands out the same value
+    world.addComponent(red[2], TestSelected{ 7 });
+    int selectedMaterial = 0;
+    world.query<const TestSelected, secs::Shared<TestMaterialId>>().forEachChunk(
+        [&](const secs::Entity*, const TestSelected*, const TestMaterialId* material, size_t) { selectedMaterial = material->id; });
+    ok &= selectedMaterial == 1;
+
+    // Prefabs and command buffers pick the archetype by value too
+    secs::Prefab prefab = world.makePrefab(TestPosition{ 1.0f, 0.0f, 0.0f }, TestMaterialId{ 2 });
+    world.instantiate(prefab, 10);
+    secs::Entity deferred = world.commands().createEntity();
+    world.commands().addComponent(deferred, TestMaterialId{ 3 });
+    world.commands().addComponent(red[3], TestMaterialId{ 2 });
+    world.flushCommands();
+    deferred = world.resolve(deferred);
+    ok &= prefab.getArchetype() == blueArch && blueArch->getEntityCount() == 61
+       && static_cast<const TestMaterialId*>(prefab.getValue(secs::ComponentRegistry::getID<TestMaterialId>()))->id == 2
+       && world.getComponent<const TestMaterialId>(deferred)->id == 3;
+
+    // Written per archetype in snapshots
+    const std::string path = (std::filesystem::temp_directory_path() / "secs_shared_test.bin").string();
+    secs::World loaded;
+    ok &= secs::Snapshot::Save(world, path) && secs::Snapshot::Load(loaded, path)
+       && loaded.getComponent<const TestMaterialId>(red[3])->id == 2 && loaded.getComponent<const TestMaterialId>(deferred)->id == 3
+       && loaded.query<secs::Shared<TestMaterialId>>().count() == world.query<secs::Shared<TestMaterialId>>().count();
+    std::filesystem::remove(path);
+
+    // Writing through a pointer would change every entity of the archetype, and a plain term has no column
+    bool threw = false;
+    try { world.getComponent<TestMaterialId>(red[0]); } catch (const std::runtime_error&) { threw = true; }
+    ok &= threw;
+    threw = false;
+    try { world.query<const TestMaterialId>(); } catch (const std::runtime_error&) { threw = true; }
+    ok &= threw;
+
+    if (ok) {
+        std::cout << "TestSharedComponents passed.\n";
+    } else {
+        std::cerr << "TestSharedComponents failed.\n";
+    }
+}
+
+void SecsTests::TestSplitComponents()
+{
+    using Registry = secs::ComponentRegistry;
+    const int spinID = Registry::getID<TestSpin>();
+    const secs::ComponentInfo& info = Registry::getInfo(spinID);
+    bool ok = Registry::isSplit(spinID) && !Registry::isSplit(Registry::getID<TestPosition>()) && info.fieldCount == 3
+           && info.fields[1].offset == offsetof(TestSpin, rate) && info.fields[2].start == 2 * sizeof(float);
+
+    secs::World world;
+    std::vector<secs::Entity> entities = world.createEntities(1000, TestPosition{}, TestSpin{ 0.0f, 2.0f, 0 });
+    std::vector<secs::Entity> defaults = world.createEntities(10, std::vector<int>{ Registry::getID<TestPosition>(), spinID });
+    ok &= world.getComponentValue<TestSpin>(defaults[0])->rate == 1.0f && world.getComponentValue<TestSpin>(entities[999])->rate == 2.0f;
+
+    // Each field is an array of its own, back to back inside the column
+    secs::Archetype* arch;
+    secs::EntityLocation loc;
+    world.locate(entities[0], arch, loc);
+    const size_t capacity = arch->getChunkCapacity();
+    bool contiguous = true;
+    world.query<secs::Split<TestSpin>, const TestPosition>().forEachChunk(
+        [&](const secs::Entity*, secs::SplitColumn<TestSpin> spin, const TestPosition*, size_t count)
+        {
+            float* angle      = spin.get<&TestSpin::angle>();
+            const float* rate = spin.get<&TestSpin::rate>();
+            int* turns        = spin.get<&TestSpin::turns>();
+            contiguous &= reinterpret_cast<const uint8_t*>(rate) == reinterpret_cast<const uint8_t*>(angle) + capacity * sizeof(float);
+            for (size_t i = 0; i < count; ++i) {
+                angle[i] += rate[i];
+                turns[i] += 1;
+            }
+        });
+    ok &= contiguous && world.getComponentValue<TestSpin>(entities[999])->angle == 2.0f
+       && world.getComponentValue<TestSpin>(entities[999])->turns == 1 && world.getComponentValue<TestSpin>(defaults[3])->angle == 1.0f;
+
+    // Rows keep their values through overwrites, moves and both kinds of removal
+    const uint32_t tick = world.advanceChangeTick();
+    for (size_t i = 0; i < 100; ++i) world.addComponent(entities[i], TestSpin{ static_cast<float>(i), 0.0f, static_cast<int>(i) });
+    for (size_t i = 0; i < 50; ++i) world.addComponent(entities[i], TestVelocity{});
+    world.destroyEntity(entities[60]);
+    world.destroyEntities(std::span<const secs::Entity>(entities).first(10));
+    world.removeComponent<TestSpin>(entities[70]);
+    ok &= world.query<secs::Split<const TestSpin>>().changedSince<TestSpin>(tick);
+    for (size_t i = 10; i < 100; ++i) {
+        if (i == 60 || i == 70) continue;
+        ok &= world.getComponentValue<TestSpin>(entities[i])->turns == static_cast<int>(i);
+    }
+    ok &= !world.getComponentValue<TestSpin>(entities[70]) && world.getComponent<TestPosition>(entities[70]);
+
+    // Entity by entity, the arrays start at the entity's row
+    world.addComponent(entities[80], TestSelected{ 1 });
+    int selectedTurns = -1;
+    world.query<const TestSelected, secs::Split<const TestSpin>>().forEachChunk(
+        [&](const secs::Entity*, const TestSelected*, secs::SplitColumn<const TestSpin> spin, size_t) { selectedTurns = spin.get<&TestSpin::turns>()[0]; });
+    ok &= selectedTurns == 80;
+
+    // Prefabs, command buffers and snapshots take and give whole structs
+    secs::Prefab prefab = world.makePrefab(TestSpin{ 5.0f, 6.0f, 7 });
+    std::vector<secs::Entity> made = world.instantiate(prefab, 300);
+    std::vector<TestSpin> overrides(20, TestSpin{ 1.0f, 1.0f, 9 });
+    overrides[19].turns = 19;
+    std::vector<secs::Entity> placed = world.instantiate(prefab, std::span<const TestSpin>(overrides));
+    world.commands().addComponent(entities[90], TestSpin{ 0.0f, 0.0f, 180 });
+    world.flushCommands();
+    ok &= world.getComponentValue<TestSpin>(made[299])->turns == 7 && world.getComponentValue<TestSpin>(made[0])->rate == 6.0f
+       && world.getComponentValue<TestSpin>(placed[0])->turns == 9 && world.getComponentValue<TestSpin>(placed[19])->turns == 19
+       && world.getComponentValue<TestSpin>(entities[90])->turns == 180;
+
+    const std::string path = (std::filesystem::temp_directory_path() / "secs_split_test.bin").string();
+    secs::World loaded;
+    ok &= secs::Snapshot::Save(world, path) && secs::Snapshot::Load(loaded, path)
+       && loaded.getComponentValue<TestSpin>(entities[99])->turns == 99 && loaded.getComponentValue<TestSpin>(made[150])->rate == 6.0f
+       && loaded.getComponentValue<TestSpin>(entities[999])->angle == 2.0f;
+    std::filesystem::remove(path);
+
+    // No per-entity address to hand out, and no whole-struct column for a plain term
+    bool threw = false;
+    try { world.getComponent<const TestSpin>(entities[99]); } catch (const std::runtime_error&) { threw = true; }
+    ok &= threw;
+    threw = false;
+    try { world.query<TestSpin>(); } catch (const std::runtime_error&) { threw = true; }
+    ok &= threw;
+
+    if (ok) {
+        std::cout << "TestSplitComponents passed.\n";
+    } else {
+        std::cerr << "TestSplitComponents failed.\n";
+    }
+}
+
+void SecsTests::TestHooksAndIndices()
+{
+    secs::World world;
+    int added = 0, removed = 0, changed = 0;
+    float removedX = 0.0f;
+    world.onAdd<TestPosition>([&](secs::Entity, const TestPosition&) { ++added; });
+    world.onRemove<TestPosition>([&](secs::Entity, const TestPosition& p) { ++removed; removedX = p.x; });
+    world.onChange<TestPosition>([&](secs::Entity, const TestPosition&) { ++changed; });
+
+    // Every way in counts, and the value is there by the time the hook runs
+    std::vector<secs::Entity> ents = world.createEntities(10, TestPosition{ 1.0f, 2.0f, 3.0f });
+    world.addComponent(world.createEntity({}), TestPosition{});
+    secs::Prefab prefab = world.makePrefab(TestPosition{}, TestVelocity{});
+    world.instantiate(prefab, 5);
+    secs::Entity deferred = world.commands().createEntity();
+    world.commands().addComponent(deferred, TestPosition{});
+    world.flushCommands();
+    bool ok = added == 17 && removed == 0;
+
+    // Writes through a pointer show up once publishChanges() looks at the ticks, a chunk at a time:
+    // the row's 11 chunk neighbours (the bulk ones, the added one, the deferred one) count too
+    world.publishChanges();
+    changed = 0;
+    world.getComponent<TestPosition>(ents[0])->x = 7.0f;
+    world.publishChanges();
+    ok &= changed == 12;
+    changed = 0;
+    world.publishChanges();
+    ok &= changed == 0;
+
+    // Removal runs while the value can still be read, destroying included
+    world.removeComponent<TestPosition>(ents[0]);
+    ok &= removed == 1 && removedX == 7.0f;
+    world.destroyEntity(ents[1]);
+    world.destroyEntities(std::vector<secs::Entity>{ ents[2], ents[3] });
+    world.commands().removeComponent<TestPosition>(ents[4]);
+    world.flushCommands();
+    ok &= removed == 5;
+
+    // Sparse and shared components have no ticks, replacing the value is the change
+    int sparseAdds = 0, sparseChanges = 0, sharedChanges = 0;
+    world.onAdd<TestSelected>([&](secs::Entity, const TestSelected&) { ++sparseAdds; });
+    world.onChange<TestSelected>([&](secs::Entity, const TestSelected&) { ++sparseChanges; });
+    const secs::HookID sharedHook = world.onChange<TestMaterialId>([&](secs::Entity, const TestMaterialId& m) { sharedChanges += m.id; });
+    world.addComponent(ents[5], TestSelected{ 1 });
+    world.addComponent(ents[5], TestSelected{ 2 });
+    world.addComponent(ents[5], TestMaterialId{ 1 });
+    world.addComponent(ents[5], TestMaterialId{ 4 });
+    world.addComponent(ents[5], TestMaterialId{ 4 });
+    world.removeHook(sharedHook);
+    world.addComponent(ents[5], TestMaterialId{ 5 });
+    ok &= sparseAdds == 1 && sparseChanges == 1 && sharedChanges == 4;
+
+    // An index fills itself from what's there, then follows along
+    std::vector<secs::Entity> labelled = world.createEntities(3, TestLabel{});
+    world.getComponent<TestLabel>(labelled[1])->text = "second";
+    {
+        secs::HashIndex<TestLabel, std::string> byText(world, &TestLabel::text);
+        ok &= byText.size() == 3 && byText.find("second") == labelled[1] && byText.findAll(TestLabel{}.text).size() == 2;
+
+        TestLabel third;
+        third.text = "third";
+        world.addComponent(labelled[2], third);
+        world.getComponent<TestLabel>(labelled[0])->text = "first";
+        world.publishChanges();
+        ok &= byText.find("first") == labelled[0] && byText.find("third") == labelled[2] && !byText.contains(TestLabel{}.text);
+
+        world.destroyEntity(labelled[1]);
+        world.createEntities(2, TestLabel{});
+        ok &= !byText.find("second") && byText.findAll(TestLabel{}.text).size() == 2 && byText.size() == 4;
+
+        // Snapshot loads announce what they restore
+        const std::string path = (std::filesystem::temp_directory_path() / "secs_hooks_test.bin").string();
+        secs::World loaded;
+        int loadedPositions = 0;
+        loaded.onAdd<TestPosition>([&](secs::Entity, const TestPosition&) { ++loadedPositions; });
+        ok &= secs::Snapshot::Save(world, path) && secs::Snapshot::Load(loaded, path)
+           && loadedPositions == static_cast<int>(world.query<const TestPosition>().count());
+        std::filesystem::remove(path);
+    }
+    // The index took its hooks with it
+    world.createEntities(2, TestLabel{});
+
+    if (ok) {
+        std::cout << "TestHooksAndIndices passed.\n";
+    } else {
+        std::cerr << "TestHooksAndIndices failed.\n";
+    }
+}
+
+void SecsTests::TestRollback()
+{
+    const int liveLabels = TestLabel::live;
+    {
+        secs::World world;
+        std::vector<secs::Entity> ents = world.createEntities(2000, TestPosition{ 1.0f, 2.0f, 3.0f }, TestVelocity{});
+        std::vector<secs::Entity> labelled = world.createEntities(3, TestLabel{});
+        world.addComponent(ents[10], TestSelected{ 3 });
+        secs::HashIndex<TestLabel, std::string> byText(world, &TestLabel::text);
+
+        size_t chunkCount = 0;
+        for (const secs::Archetype* arch : world.getArchetypeList()) chunkCount += arch->getChunks().size();
+
+        // The first frame copies everything, the next only the chunk that was written
+        secs::Rollback history(world, 4);
+        history.capture(1);
+        bool ok = history.getCopiedChunks() == chunkCount && history.getSharedChunks() == 0;
+        world.getComponent<TestPosition>(ents[0])->x = 7.0f;
+        history.capture(2);
+        ok &= history.getCopiedChunks() == 1 && history.getSharedChunks() == chunkCount - 1;
+
+        // Anything goes, then back to frame 1
+        world.getComponent<TestPosition>(ents[0])->x = 9.0f;
+        world.destroyEntity(ents[1]);
+        world.removeComponent<TestSelected>(ents[10]);
+        world.getComponent<TestLabel>(labelled[0])->text = "renamed";
+        world.addComponent(labelled[1], TestVelocity{});
+        secs::Entity spawned = world.createEntity({});
+        world.addComponent(spawned, TestLabel{});
+        world.publishChanges();
+        ok &= byText.contains("renamed");
+
+        ok &= history.restore(1) && !history.contains(2) && !history.restore(2) && history.size() == 1;
+        ok &= world.getEntityCount() == 2003 && world.isAlive(ents[1]) && !world.isAlive(spawned);
+        ok &= world.getComponent<const TestPosition>(ents[0])->x == 1.0f;
+        ok &= world.getComponent<const TestPosition>(ents[1999])->z == 3.0f;
+        ok &= world.getComponent<const TestSelected>(ents[10]) && world.getComponent<const TestSelected>(ents[10])->order == 3;
+        ok &= !world.getComponent<const TestVelocity>(labelled[1]);
+        ok &= world.getComponent<const TestLabel>(labelled[0])->text == TestLabel{}.text;
+        ok &= world.query<const TestLabel>().count() == 3;
+
+        // Indices went along through the hooks
+        ok &= !byText.contains("renamed") && byText.size() == 3;
+
+        // Re-simulating replaces the frames after it; chunks restore left alone stay shared
+        world.getComponent<TestPosition>(ents[1999])->x = 5.0f;
+        history.capture(2);
+        ok &= history.getCopiedChunks() < chunkCount && history.getSharedChunks() > 0;
+
+        // A clone is its own world with the same handles
+        secs::World branch;
+        secs::Rollback::clone(world, branch);
+        ok &= branch.getEntityCount() == world.getEntityCount() && branch.isAlive(ents[1]) && !branch.isAlive(spawned);
+        ok &= branch.getComponent<const TestPosition>(ents[1999])->x == 5.0f;
+        ok &= branch.getComponent<const TestSelected>(ents[10])->order == 3;
+        branch.getComponent<TestLabel>(labelled[2])->text = "branch";
+        branch.destroyEntity(ents[0]);
+        ok &= world.getComponent<const TestLabel>(labelled[2])->text == TestLabel{}.text && world.isAlive(ents[0]);
+        ok &= branch.query<const TestPosition>().count() == 1999;
+
+        if (ok) {
+            std::cout << "TestRollback passed.\n";
+        } else {
+            std::cerr << "TestRollback failed.\n";
+        }
+    }
+    if (TestLabel::live != liveLabels) {
+        std::cerr << "TestRollback failed: " << TestLabel::live - liveLabels << " labels leaked.\n";
+    }
+}
+
+void SecsTests::RunAllTests()
+{
+    std::cout << "==== Secs tests ====" << std::endl;
+    RegisterTestComponents();
+    TestAddRemoveComponent();
+    TestTransitionEdgesCached();
+    TestChunkSwapAndPop();
+    TestStaleHandleAfterReuse();
+    TestSchedulerStages();
+    TestDeferredCommands();
+    TestCommandOrder();
+    TestBulkCreateDestroy();
+    TestNonTrivialComponents();
+    TestChangeTicks();
+    TestSparseComponents();
+    TestSnapshotRoundTrip();
+    TestTransformHierarchy();
+    TestChunkAllocator();
+    TestArchetypeStats();
+    TestPrefabInstantiate();
+    TestQueryFilters();
+    TestArchetypeCompaction();
+    TestComponentRegistry();
+    TestSharedComponents();
+    TestSplitComponents();
+    TestHooksAndIndices();
+    TestRollback();
+    std::cout << "====================" << std::endl;
+}
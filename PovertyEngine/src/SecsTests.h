@@ -0,0 +1,34 @@
+#pragma once
+#include "Secs.h"
+// SecsTests Class Declaration
+class SecsTests {
+public:
+    // Run all the tests
+    static void RunAllTests();
+
+private:
+    // Individual tests
+    static void TestAddRemoveComponent();
+    static void TestTransitionEdgesCached();
+    static void TestChunkSwapAndPop();
+    static void TestStaleHandleAfterReuse();
+    static void TestSchedulerStages();
+    static void TestDeferredCommands();
+    static void TestCommandOrder();
+    static void TestBulkCreateDestroy();
+    static void TestNonTrivialComponents();
+    static void TestChangeTicks();
+    static void TestSparseComponents();
+    static void TestSnapshotRoundTrip();
+    static void TestTransformHierarchy();
+    static void TestChunkAllocator();
+    static void TestArchetypeStats();
+    static void TestPrefabInstantiate();
+    static void TestQueryFilters();
+    static void TestArchetypeCompaction();
+    static void TestComponentRegistry();
+    static void TestSharedComponents();
+    static void TestSplitComponents();
+    static void TestHooksAndIndices();
+    static void TestRollback();
+};
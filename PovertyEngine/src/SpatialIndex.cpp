@@ -0,0 +1,188 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex::SpatialIndex(secs::World& world, float cellSize)
+    : world(world), cellSize(cellSize)
+{
+    world.query<const Transform, const AABB>().forEachChunk(
+        [this](const secs::Entity* ents, const Transform*, const AABB*, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Update(ents[i]);
+            }
+        });
+
+    // Update reads both components, so the same hook serves either one
+    for (int compID : { secs::ComponentRegistry::getID<Transform>(), secs::ComponentRegistry::getID<AABB>() })
+    {
+        hooks.push_back(world.addHook(secs::HookEvent::Add, compID, [this](secs::Entity e) { Update(e); }));
+        hooks.push_back(world.addHook(secs::HookEvent::Change, compID, [this](secs::Entity e) { Update(e); }));
+        hooks.push_back(world.addHook(secs::HookEvent::Remove, compID, [this](secs::Entity e) { Erase(e.id); }));
+    }
+}
+
+SpatialIndex::~SpatialIndex()
+{
+    for (secs::HookID id : hooks)
+    {
+        world.removeHook(id);
+    }
+}
+
+void SpatialIndex::Query(const AABB& box, std::vector<secs::Entity>& out) const
+{
+    auto overlaps = [&box](const AABB& bounds)
+    {
+        return bounds.max.x >= box.min.x && bounds.min.x <= box.max.x
+            && bounds.max.y >= box.min.y && bounds.min.y <= box.max.y
+            && bounds.max.z >= box.min.z && bounds.min.z <= box.max.z;
+    };
+
+    // Something spanning several cells shows up in each of them
+    std::vector<uint32_t> found;
+    const CellRange range = CellsOf(box);
+    const int64_t area = (int64_t(range.maxX) - range.minX + 1) * (int64_t(range.maxZ) - range.minZ + 1);
+    if (area > static_cast<int64_t>(cells.size()))
+    {
+        // A box bigger than what's occupied: walk the occupied cells instead
+        for (const auto& [key, ids] : cells)
+        {
+            const int x = static_cast<int32_t>(key >> 32);
+            const int z = static_cast<int32_t>(key & 0xFFFFFFFFu);
+            if (x >= range.minX && x <= range.maxX && z >= range.minZ && z <= range.maxZ)
+            {
+                found.insert(found.end(), ids.begin(), ids.end());
+            }
+        }
+    }
+    else
+    {
+        for (int x = range.minX; x <= range.maxX; ++x)
+        {
+            for (int z = range.minZ; z <= range.maxZ; ++z)
+            {
+                auto cell = cells.find(CellKey(x, z));
+                if (cell != cells.end())
+                {
+                    found.insert(found.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+    found.insert(found.end(), large.begin(), large.end());
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    for (uint32_t id : found)
+    {
+        const Entry& entry = entries.at(id);
+        if (overlaps(entry.bounds))
+        {
+            out.push_back(entry.entity);
+        }
+    }
+}
+
+void SpatialIndex::Update(secs::Entity e)
+{
+    const Transform* transform = world.getComponent<const Transform>(e);
+    const AABB* aabb = world.getComponent<const AABB>(e);
+    if (!transform || !aabb)
+    {
+        Erase(e.id);
+        return;
+    }
+
+    const AABB bounds = PEPhysics::TransformAABBToWorld(*aabb, *transform);
+    const CellRange range = CellsOf(bounds);
+    auto it = entries.find(e.id);
+    if (it != entries.end() && it->second.entity == e && it->second.cells == range)
+    {
+        // Most moves stay inside the same cells
+        it->second.bounds = bounds;
+        return;
+    }
+    Erase(e.id);
+    entries.emplace(e.id, Entry{ e, bounds, range });
+    Link(e.id, range);
+}
+
+void SpatialIndex::Erase(uint32_t id)
+{
+    auto it = entries.find(id);
+    if (it == entries.end())
+    {
+        return;
+    }
+    Unlink(id, it->second.cells);
+    entries.erase(it);
+}
+
+void SpatialIndex::Link(uint32_t id, const CellRange& range)
+{
+    if (range.IsLarge())
+    {
+        large.push_back(id);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; ++x)
+    {
+        for (int z = range.minZ; z <= range.maxZ; ++z)
+        {
+            cells[CellKey(x, z)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::Unlink(uint32_t id, const CellRange& range)
+{
+    auto swapRemove = [id](std::vector<uint32_t>& ids)
+    {
+        auto it = std::find(ids.begin(), ids.end(), id);
+        if (it != ids.end())
+        {
+            *it = ids.back();
+            ids.pop_back();
+        }
+    };
+
+    if (range.IsLarge())
+    {
+        swapRemove(large);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; ++x)
+    {
+        for (int z = range.minZ; z <= range.maxZ; ++z)
+        {
+            auto cell = cells.find(CellKey(x, z));
+            if (cell == cells.end())
+            {
+                continue;
+            }
+            swapRemove(cell->second);
+            if (cell->second.empty())
+            {
+                cells.erase(cell);
+            }
+        }
+    }
+}
+
+SpatialIndex::CellRange SpatialIndex::CellsOf(const AABB& bounds) const
+{
+    // Clamped so a stray huge or infinite bound can't overflow the cell coordinates
+    auto cell = [this](float coordinate)
+    {
+        return static_cast<int>(std::clamp(std::floor(coordinate / cellSize), -1.0e9f, 1.0e9f));
+    };
+    return { cell(bounds.min.x), cell(bounds.min.z), cell(bounds.max.x), cell(bounds.max.z) };
+}
+
+uint64_t SpatialIndex::CellKey(int x, int z)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Core.h"
+#include "Secs.h"
+#include "PEPhysics.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+    ===================
+    SPATIAL INDEX
+    ===================
+    World-space bounds of every entity with a Transform and an AABB, bucketed in a uniform grid
+    of columns on the XZ plane, so "what's near this box" only looks at the cells the box covers
+    instead of at every entity.
+    - Follows the World's hooks: entities come and go right away, moves land when
+      World::publishChanges() reports their Transform or AABB chunk as written.
+    - Bounds come from Transform::model, i.e. whatever RenderSystem last rebuilt, so they can be a
+      frame behind. Results are candidates: do the exact test on the current components.
+    - Entities covering more than MAX_CELLS cells (the ground, say) go in one list every query checks.
+    Has to go before the world does. Not copyable or movable, the hooks point back at it.
+*/
+class PE_API SpatialIndex
+{
+public:
+    explicit SpatialIndex(secs::World& world, float cellSize = 32.0f);
+    ~SpatialIndex();
+
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+    // Append every entity whose indexed bounds overlap box to out, each once
+    void Query(const AABB& box, std::vector<secs::Entity>& out) const;
+
+    size_t GetCount() const { return entries.size(); }
+
+    static constexpr int MAX_CELLS = 64;
+
+private:
+    struct CellRange {
+        int minX, minZ, maxX, maxZ;
+
+        bool operator==(const CellRange& other) const
+        {
+            return minX == other.minX && minZ == other.minZ && maxX == other.maxX && maxZ == other.maxZ;
+        }
+        bool IsLarge() const { return (int64_t(maxX) - minX + 1) * (int64_t(maxZ) - minZ + 1) > MAX_CELLS; }
+    };
+
+    struct Entry {
+        secs::Entity entity;
+        AABB bounds;
+        CellRange cells;
+    };
+
+    // Re-read e's Transform and AABB and move it to the cells they cover now, or drop it if one is gone
+    void Update(secs::Entity e);
+    void Erase(uint32_t id);
+
+    void Link(uint32_t id, const CellRange& range);
+    void Unlink(uint32_t id, const CellRange& range);
+
+    CellRange CellsOf(const AABB& bounds) const;
+    static uint64_t CellKey(int x, int z);
+
+    secs::World& world;
+    float cellSize;
+    std::unordered_map<uint32_t, Entry> entries;                // Entity::id -> what's indexed for it
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;  // Cell -> entity ids in it
+    std::vector<uint32_t> large;                                // Ids too big for the grid
+    std::vector<secs::HookID> hooks;
+};
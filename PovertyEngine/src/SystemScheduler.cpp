@@ -0,0 +1,92 @@
+#include "SystemScheduler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+void SystemScheduler::Build(const std::vector<secs::System>& systems)
+{
+    // stageOf[j] = one past the latest stage of any earlier system that conflicts with j
+    std::vector<size_t> stageOf(systems.size(), 0);
+    size_t stageCount = 0;
+    for (size_t j = 0; j < systems.size(); ++j)
+    {
+        for (size_t i = 0; i < j; ++i)
+        {
+            if (systems[i].conflictsWith(systems[j]))
+                stageOf[j] = std::max(stageOf[j], stageOf[i] + 1);
+        }
+        stageCount = std::max(stageCount, stageOf[j] + 1);
+    }
+
+    stages.assign(stageCount, Stage{});
+    for (size_t j = 0; j < systems.size(); ++j)
+    {
+        Stage& stage = stages[stageOf[j]];
+        if (systems[j].isMainThreadOnly())
+            stage.mainThread.push_back(j);
+        else
+            stage.workers.push_back(j);
+    }
+
+    timeline.assign(systems.size(), TimelineEntry{});
+    for (size_t j = 0; j < systems.size(); ++j)
+    {
+        timeline[j].stage = stageOf[j];
+    }
+    dirty = false;
+}
+
+void SystemScheduler::Run(std::vector<secs::System>& systems, secs::World& world)
+{
+    if (dirty || timeline.size() != systems.size())
+        Build(systems);
+
+    const Clock::time_point frameStart = Clock::now();
+
+    // Every system writes only its own timeline entry, so workers don't need to sync here
+    auto runSystem = [&](size_t index, size_t thread)
+    {
+        TimelineEntry& entry = timeline[index];
+        entry.thread = thread;
+        entry.startMs = MillisecondsSince(frameStart);
+        // Tag what the system records, its commands flush in schedule order whichever thread it ran on
+        const secs::CommandSource outer = world.getCommandSource();
+        world.setCommandSource({ static_cast<uint32_t>(index + 1) });
+        systems[index].execute(world);
+        world.setCommandSource(outer);
+        entry.endMs = MillisecondsSince(frameStart);
+    };
+
+    for (const Stage& stage : stages)
+    {
+        if (stage.workers.size() == 1)
+        {
+            runSystem(stage.workers[0], JobSystem::GetThreadIndex());
+        }
+        else if (!stage.workers.empty())
+        {
+            JobSystem::Get().ParallelFor(stage.workers.size(), [&](size_t i, size_t thread)
+            {
+                runSystem(stage.workers[i], thread);
+            });
+        }
+
+        for (size_t index : stage.mainThread)
+        {
+            runSystem(index, JobSystem::GetThreadIndex());
+        }
+    }
+
+    frameMs = MillisecondsSince(frameStart);
+}
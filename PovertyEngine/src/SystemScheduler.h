@@ -0,0 +1,53 @@
+#pragma once
+#include "Core.h"
+#include "Secs.h"
+
+#include <vector>
+
+/*
+    ===================
+    SYSTEM SCHEDULER
+    ===================
+    - Looks at what every system reads and writes and puts it in the first stage
+      after every earlier system it conflicts with. Conflicting systems therefore
+      always run in the order they were added, and systems in the same stage
+      touch disjoint data, so the result doesn't depend on thread timing.
+      Commands they record are tagged with their index and flush in that order too.
+    - A stage runs its systems on the JobSystem, then its main-thread systems
+      on the calling thread. A stage with one system runs it directly, so the
+      system's own parallel queries still get the whole pool.
+    - Records a timeline (start, end, thread) per system each frame.
+*/
+class PE_API SystemScheduler
+{
+public:
+    struct TimelineEntry {
+        size_t stage = 0;
+        size_t thread = 0;
+        double startMs = 0.0; // Relative to the start of Run
+        double endMs = 0.0;
+    };
+
+    // The system list changed, rebuild the stages on the next Run
+    void Invalidate() { dirty = true; }
+
+    void Run(std::vector<secs::System>& systems, secs::World& world);
+
+    // One entry per system, same order as the system list
+    const std::vector<TimelineEntry>& GetTimeline() const { return timeline; }
+    size_t GetStageCount() const { return stages.size(); }
+    double GetFrameMs() const { return frameMs; }
+
+private:
+    struct Stage {
+        std::vector<size_t> workers;    // Can run on any thread
+        std::vector<size_t> mainThread; // Run on the caller once the workers are done
+    };
+
+    void Build(const std::vector<secs::System>& systems);
+
+    std::vector<Stage> stages;
+    std::vector<TimelineEntry> timeline;
+    double frameMs = 0.0;
+    bool dirty = true;
+};
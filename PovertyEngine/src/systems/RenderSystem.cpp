@@ -6,72 +6,91 @@
 #include <glad.h>
 void RenderSystem::RegisterComponents(secs::World* world)
 {
-    secs::ComponentRegistry::registerType<Transform>("Transform");
-    secs::ComponentRegistry::registerType<Material>("Material");
-    secs::ComponentRegistry::registerType<Shader>("Shader");
-    secs::ComponentRegistry::registerType<Mesh>("Mesh");
+    TransformHierarchy::RegisterComponents();
+    // Shared: one value per archetype, entities drawn alike end up in the same chunks
+    secs::ComponentRegistry::registerType<Material>("Material", secs::StorageKind::Shared);
+    secs::ComponentRegistry::registerType<Shader>("Shader", secs::StorageKind::Shared);
+    secs::ComponentRegistry::registerType<Mesh>("Mesh", secs::StorageKind::Shared);
 }
 
 
+uint32_t RenderSystem::lastModelRebuildTick = 0;
+TransformHierarchy RenderSystem::hierarchy;
+
 int RenderSystem::Render(secs::World& world)
 {
     int renderedObjects = 0;
 
-    // Use queryChunks to efficiently process entities with the required components
-    secs::queryChunks<Transform, Mesh, Material, Shader>(
-        world,
-        [&](const std::vector<secs::Entity>& ents,
-            Transform* transforms,
-            Mesh* meshes,
-            Material* materials,
-            Shader* shaders,
-            size_t count)
+    // Rebuild the model matrices on every thread first, the GL calls below have to stay on this one.
+    // Only chunks whose transforms were written since the last rebuild, static props cost nothing.
+    // Every Transform, not just the drawn ones, so invisible pivots can still be parents
+    world.query<Transform>().forEachChunkChangedSinceParallel<Transform>(
+        lastModelRebuildTick,
+        [](const secs::Entity*, Transform* transforms, size_t count)
         {
             for (size_t i = 0; i < count; ++i)
             {
-                // Update the transform's model matrix
                 transforms[i].UpdateModelMatrix();
+            }
+        });
+    // Children are local at this point, put them under their parents
+    hierarchy.Propagate(world, lastModelRebuildTick);
+    // The rebuild's own writes land in the tick that gets closed here, so they don't trigger another one
+    lastModelRebuildTick = world.advanceChangeTick();
+
+    // Mesh, Material and Shader are shared components, so every entity of a chunk draws the same
+    // thing: bind the state once per chunk, then only the model matrix changes per draw.
+    // Read-only, so drawing doesn't mark anything as changed
+    secs::queryChunks<const Transform, secs::Shared<Mesh>, secs::Shared<Material>, secs::Shared<Shader>>(
+        world,
+        [&](const secs::Entity*,
+            const Transform* transforms,
+            const Mesh* mesh,
+            const Material* material,
+            const Shader* shader,
+            size_t count)
+        {
+            // Use the shader program
+            glUseProgram(shader->program);
 
-                // Use the shader program
-                glUseProgram(shaders[i].program);
-
-                // Set global uniforms
-                GLint camMatrixLoc = glGetUniformLocation(shaders[i].program, "camMatrix");
-                glUniformMatrix4fv(camMatrixLoc, 1, GL_FALSE, glm::value_ptr(Engine::camMatrix));
+            // Set global uniforms
+            GLint camMatrixLoc = glGetUniformLocation(shader->program, "camMatrix");
+            glUniformMatrix4fv(camMatrixLoc, 1, GL_FALSE, glm::value_ptr(Engine::camMatrix));
 
-                GLint lightColorLoc = glGetUniformLocation(shaders[i].program, "lightColor");
-                glUniform3fv(lightColorLoc, 1, glm::value_ptr(Engine::lightColor));
+            GLint lightColorLoc = glGetUniformLocation(shader->program, "lightColor");
+            glUniform3fv(lightColorLoc, 1, glm::value_ptr(Engine::lightColor));
 
-                GLint lightDirLoc = glGetUniformLocation(shaders[i].program, "lightDir");
-                glUniform3fv(lightDirLoc, 1, glm::value_ptr(Engine::lightDir));
+            GLint lightDirLoc = glGetUniformLocation(shader->program, "lightDir");
+            glUniform3fv(lightDirLoc, 1, glm::value_ptr(Engine::lightDir));
 
-                GLint viewPosLoc = glGetUniformLocation(shaders[i].program, "viewPos");
-                glUniform3fv(viewPosLoc, 1, glm::value_ptr(Engine::camPos));
+            GLint viewPosLoc = glGetUniformLocation(shader->program, "viewPos");
+            glUniform3fv(viewPosLoc, 1, glm::value_ptr(Engine::camPos));
 
-                // 2. Get the uniform location for your sampler2D
-                GLuint texLoc = glGetUniformLocation(shaders[i].program, "diffuseTexture");
+            // 2. Get the uniform location for your sampler2D
+            GLuint texLoc = glGetUniformLocation(shader->program, "diffuseTexture");
 
-                // 3. Activate texture unit 0, then bind your actual texture ID to that unit
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, materials[i].diffuseTextureID);
-                // 4. Tell the sampler in the shader that "diffuseTexture" corresponds to texture unit 0
-                glUniform1i(texLoc, 0);
+            // 3. Activate texture unit 0, then bind your actual texture ID to that unit
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, material->diffuseTextureID);
+            // 4. Tell the sampler in the shader that "diffuseTexture" corresponds to texture unit 0
+            glUniform1i(texLoc, 0);
 
-                
-                // Bind the VAO
-                glBindVertexArray(meshes[i].VAO);
+            // Bind the VAO
+            glBindVertexArray(mesh->VAO);
 
+            GLint modelLoc = glGetUniformLocation(shader->program, "model");
+            for (size_t i = 0; i < count; ++i)
+            {
                 // Set the model matrix for the current entity
-                GLint modelLoc = glGetUniformLocation(shaders[i].program, "model");
                 glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(transforms[i].model));
 
                 // Draw the mesh
-                glDrawElements(GL_TRIANGLES, meshes[i].indexCount, GL_UNSIGNED_INT, nullptr);
+                glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, nullptr);
                 renderedObjects++;
-
-                // Unbind the VAO
-                glBindVertexArray(0);
             }
+
+            // Unbind the VAO
+            glBindVertexArray(0);
         });
 
     return renderedObjects;
@@ -5,6 +5,7 @@
 #include <gtc/type_ptr.hpp>
 
 #include "Secs.h"
+#include "TransformSystem.h"
 using ShaderHandle = uint32_t;
 using MeshHandle = uint32_t;
 
@@ -25,5 +26,11 @@ class RenderSystem
 public:
     static int Render(secs::World& world);
     static void RegisterComponents(secs::World* world);
+
+private:
+    // World change tick the model matrices were last rebuilt at
+    static uint32_t lastModelRebuildTick;
+    // Turns the local models of entities with a Parent into world ones
+    static TransformHierarchy hierarchy;
 };
 
@@ -0,0 +1,183 @@
+#include "TransformSystem.h"
+
+#include <unordered_map>
+
+void TransformHierarchy::RegisterComponents()
+{
+    secs::ComponentRegistry::registerType<Transform>("Transform");
+    secs::ComponentRegistry::registerType<Parent>("Parent");
+}
+
+void TransformHierarchy::Rebuild(secs::World& world)
+{
+    // Gather every (child, parent) pair
+    std::vector<Node> gathered;
+    std::unordered_map<uint32_t, uint32_t> indexOf; // Entity::id -> index in gathered
+    world.query<const Parent>().forEachChunk([&](const secs::Entity* ents, const Parent* links, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            indexOf[ents[i].id] = static_cast<uint32_t>(gathered.size());
+            gathered.push_back({ ents[i], links[i].entity, NO_NODE });
+        }
+    });
+    linkCount = gathered.size();
+    auto parentIndex = [&](const Node& node)
+    {
+        auto it = indexOf.find(node.parent.id);
+        return it != indexOf.end() && gathered[it->second].entity == node.parent ? it->second : NO_NODE;
+    };
+
+    // Depth of each node: walk up until something with a known depth, then fill in the path on the way back.
+    // Only happens when the hierarchy changed, the per-frame pass never walks up.
+    constexpr uint32_t UNKNOWN = 0, VISITING = UINT32_MAX - 1, CYCLE = UINT32_MAX;
+    std::vector<uint32_t> depth(gathered.size(), UNKNOWN);
+    std::vector<uint32_t> path;
+    uint32_t maxDepth = 0;
+    for (uint32_t start = 0; start < gathered.size(); ++start)
+    {
+        path.clear();
+        uint32_t current = start;
+        uint32_t base = 0; // Depth of whatever the walk ended on, 0 for a root
+        while (current != NO_NODE && depth[current] == UNKNOWN)
+        {
+            depth[current] = VISITING;
+            path.push_back(current);
+            current = parentIndex(gathered[current]);
+        }
+        if (current != NO_NODE) {
+            base = depth[current] == VISITING ? CYCLE : depth[current];
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it)
+        {
+            base = base == CYCLE ? CYCLE : base + 1;
+            depth[*it] = base;
+        }
+        if (base != CYCLE) maxDepth = std::max(maxDepth, base);
+    }
+
+    // Counting sort by depth. Nodes caught in a cycle are left out and keep whatever model they have
+    depthStarts.assign(maxDepth + 1, 0);
+    for (uint32_t d : depth) {
+        if (d != CYCLE) ++depthStarts[d - 1];
+    }
+    uint32_t offset = 0;
+    for (uint32_t& start : depthStarts)
+    {
+        uint32_t count = start;
+        start = offset;
+        offset += count;
+    }
+    if (offset != gathered.size()) {
+        std::cerr << "TransformHierarchy: " << gathered.size() - offset << " entities are their own ancestors, skipping them" << std::endl;
+    }
+
+    std::vector<uint32_t> sortedIndex(gathered.size(), NO_NODE);
+    std::vector<uint32_t> cursor(depthStarts.begin(), depthStarts.end());
+    nodes.resize(offset);
+    for (uint32_t i = 0; i < gathered.size(); ++i)
+    {
+        if (depth[i] == CYCLE) continue;
+        sortedIndex[i] = cursor[depth[i] - 1]++;
+        nodes[sortedIndex[i]] = gathered[i];
+    }
+    for (Node& node : nodes)
+    {
+        uint32_t parent = parentIndex(node);
+        node.parentNode = parent == NO_NODE ? NO_NODE : sortedIndex[parent];
+    }
+    detached.assign(nodes.size(), 0);
+}
+
+void TransformHierarchy::Propagate(secs::World& world, uint32_t sinceTick)
+{
+    auto& linked = world.query<const Parent>();
+    if (linked.count() != linkCount || linked.changedSince<Parent>(sinceTick)) {
+        Rebuild(world);
+    }
+
+    const int transformID = secs::ComponentRegistry::getID<Transform>();
+    const int parentID    = secs::ComponentRegistry::getID<Parent>();
+    struct Resolved {
+        Transform* transform = nullptr;
+        bool changed = false;
+    };
+    auto resolve = [&](secs::Entity e, secs::Archetype*& arch, secs::EntityLocation& loc)
+    {
+        Resolved out;
+        if (world.locate(e, arch, loc)) {
+            out.transform = reinterpret_cast<Transform*>(arch->getComponentData(loc, transformID));
+            // A re-parented node moves as well
+            out.changed   = out.transform && (arch->changedSince(loc, transformID, sinceTick) || arch->changedSince(loc, parentID, sinceTick));
+        }
+        return out;
+    };
+
+    // Serial pass in depth order: find out what's dirty. Cheap compared to the matrix math
+    const size_t count = nodes.size();
+    transforms.assign(count, nullptr);
+    parents.assign(count, nullptr);
+    dirty.assign(count, 0);
+    batch.clear();
+    struct Touched {
+        secs::Archetype* archetype;
+        secs::EntityLocation location;
+    };
+    std::vector<Touched> touched;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Node& node = nodes[i];
+        secs::Archetype* arch;
+        secs::EntityLocation loc;
+        Resolved own = resolve(node.entity, arch, loc);
+        if (!own.transform) continue;
+
+        bool parentDirty;
+        if (node.parentNode != NO_NODE) {
+            parents[i]  = transforms[node.parentNode];
+            parentDirty = dirty[node.parentNode] != 0;
+        } else {
+            secs::Archetype* parentArch;
+            secs::EntityLocation parentLoc;
+            Resolved parent = resolve(node.parent, parentArch, parentLoc);
+            parents[i]  = parent.transform;
+            parentDirty = parent.changed;
+        }
+
+        // Losing the parent is a change too, but only once
+        const bool lostParent = !parents[i] && !detached[i];
+        detached[i] = !parents[i];
+
+        transforms[i] = own.transform;
+        if (own.changed || parentDirty || lostParent) {
+            dirty[i] = 1;
+            batch.push_back(i);
+            touched.push_back({ arch, loc });
+        }
+    }
+    // Stamped after the pass, so a node doesn't make its chunk neighbours look written
+    for (const Touched& t : touched) {
+        t.archetype->markChanged(t.location, transformID);
+    }
+
+    // One parallel batch per depth, parents are final by the time their children's batch starts
+    constexpr size_t BLOCK = 256;
+    size_t begin = 0;
+    for (size_t d = 0; d + 1 < depthStarts.size() && begin < batch.size(); ++d)
+    {
+        size_t end = begin;
+        while (end < batch.size() && batch[end] < depthStarts[d + 1]) ++end;
+
+        JobSystem::Get().ParallelFor((end - begin + BLOCK - 1) / BLOCK, [&](size_t block, size_t)
+        {
+            const size_t last = std::min(end, begin + (block + 1) * BLOCK);
+            for (size_t k = begin + block * BLOCK; k < last; ++k)
+            {
+                const uint32_t i = batch[k];
+                const glm::mat4 parentModel = parents[i] ? parents[i]->model : glm::mat4(1.0f);
+                transforms[i]->model = parentModel * transforms[i]->LocalMatrix();
+            }
+        });
+        begin = end;
+    }
+}
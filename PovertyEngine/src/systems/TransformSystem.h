@@ -3,6 +3,9 @@
 #include <gtc/matrix_transform.hpp> // For glm::translate, glm::rotate, glm::scale
 #define GLM_ENABLE_EXPERIMENTAL
 #include <gtx/quaternion.hpp>
+#include <vector>
+
+#include "Secs.h"
 
 struct Transform {
     glm::vec3 position = glm::vec3(0.0f);
@@ -12,14 +15,20 @@ struct Transform {
 
     void UpdateModelMatrix()
     {
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, position);
+        model = LocalMatrix();
+    }
+
+    // Matrix of position, rotation and scale alone. Same as model unless the entity has a Parent
+    glm::mat4 LocalMatrix() const
+    {
+        glm::mat4 local = glm::mat4(1.0f);
+        local = glm::translate(local, position);
 
         // Convert the quaternion to a 4x4 rotation matrix
-        model *= glm::toMat4(not_rotation);
+        local *= glm::toMat4(not_rotation);
 
         // Apply scaling
-        model = glm::scale(model, scale);
+        return glm::scale(local, scale);
     }
 
     void LookAt(const glm::vec3& target, const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f))
@@ -56,3 +65,58 @@ struct Transform {
         return glm::normalize(glm::rotate(not_rotation, glm::vec3(0.0f, 0.0f, -1.0f)));
     }
 };
+
+// Hangs an entity under another one. Its Transform is then relative to the parent's
+// and model ends up as parent.model * local.
+struct Parent {
+    secs::Entity entity;
+};
+
+/*
+    ===================
+    TRANSFORM HIERARCHY
+    ===================
+    - Every entity with a Parent is a node. Nodes sit in one array sorted by depth, so walking
+      it front to back always finishes a parent before any of its children. No recursion, and
+      a node finds its parent by index instead of walking up the tree.
+    - Propagate only recomputes dirty subtrees: a node is dirty if its Transform or Parent chunk
+      was written since sinceTick, or its parent is dirty. Each depth is one parallel batch.
+    - The order is rebuilt when Parent components were added, removed or written since sinceTick.
+    - Children whose parent died (or never had a Transform) fall back to their local matrix.
+*/
+class TransformHierarchy
+{
+public:
+    static void RegisterComponents();
+
+    // Bring the model matrix of every node up to date. Models of the roots have to be final already.
+    // Not while systems are running.
+    void Propagate(secs::World& world, uint32_t sinceTick);
+
+    size_t GetNodeCount() const { return nodes.size(); }
+    size_t GetDepthCount() const { return depthStarts.empty() ? 0 : depthStarts.size() - 1; }
+    // Nodes recomputed by the last Propagate
+    size_t GetUpdatedCount() const { return batch.size(); }
+
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct Node {
+        secs::Entity entity;
+        secs::Entity parent;
+        uint32_t parentNode; // Index of the parent in nodes, NO_NODE when the parent is a root
+    };
+
+    void Rebuild(secs::World& world);
+
+    std::vector<Node> nodes;
+    size_t linkCount = 0; // Parent components the last Rebuild saw, cycles included, unlike nodes
+    std::vector<uint32_t> depthStarts; // Depth d + 1 is nodes[depthStarts[d], depthStarts[d + 1])
+    std::vector<uint8_t> detached;     // Parent couldn't be resolved last time, indexed like nodes
+
+    // Scratch for Propagate, indexed like nodes
+    std::vector<Transform*> transforms;
+    std::vector<const Transform*> parents;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> batch; // Dirty node indices, ascending, so grouped by depth
+};
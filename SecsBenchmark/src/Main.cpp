@@ -0,0 +1,329 @@
+#include "Secs.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+    =================================================
+    SECS BENCHMARK
+    =================================================
+    Headless timings of the ECS, written as JSON so two revisions can be diffed:
+        SecsBenchmark [output.json] [--quick]
+    Every result is the best of a few repetitions, in ns per operation, plus heap
+    allocations per operation counted by replacing the global operator new.
+    --quick drops the 1M runs, for smoke testing.
+*/
+
+// ============ Allocation counting ============
+static std::atomic<size_t> allocationCount{0};
+
+static void* countedAlloc(size_t size, size_t alignment)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size = std::max<size_t>(size, 1);
+    void* ptr;
+#ifdef _WIN32
+    ptr = _aligned_malloc(size, alignment);
+#else
+    ptr = alignment <= alignof(std::max_align_t) ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+static void countedFree(void* ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* operator new(size_t size) { return countedAlloc(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAlloc(size, static_cast<size_t>(alignment)); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { countedFree(ptr); }
+
+namespace
+{
+    // Eight distinct 16 byte components
+    template<int N>
+    struct BenchComponent
+    {
+        float value[4];
+    };
+    using C0 = BenchComponent<0>;
+    using C1 = BenchComponent<1>;
+    using C2 = BenchComponent<2>;
+    using C3 = BenchComponent<3>;
+    using C4 = BenchComponent<4>;
+    using C5 = BenchComponent<5>;
+    using C6 = BenchComponent<6>;
+    using C7 = BenchComponent<7>;
+
+    // Same 16 bytes, stored one array per field
+    struct SplitComponent
+    {
+        float x, y, z, w;
+    };
+}
+
+template<>
+struct secs::SplitFields<SplitComponent>
+{
+    static constexpr auto members = std::make_tuple(&SplitComponent::x, &SplitComponent::y, &SplitComponent::z, &SplitComponent::w);
+};
+
+namespace
+{
+    std::vector<int> componentIDs;
+
+    void RegisterComponents()
+    {
+        componentIDs = {
+            secs::ComponentRegistry::registerType<C0>("C0"), secs::ComponentRegistry::registerType<C1>("C1"),
+            secs::ComponentRegistry::registerType<C2>("C2"), secs::ComponentRegistry::registerType<C3>("C3"),
+            secs::ComponentRegistry::registerType<C4>("C4"), secs::ComponentRegistry::registerType<C5>("C5"),
+            secs::ComponentRegistry::registerType<C6>("C6"), secs::ComponentRegistry::registerType<C7>("C7"),
+        };
+        secs::ComponentRegistry::registerType<SplitComponent>("SplitComponent");
+    }
+
+    std::vector<int> FirstComponents(size_t count)
+    {
+        return std::vector<int>(componentIDs.begin(), componentIDs.begin() + count);
+    }
+
+    // Keeps the optimizer from dropping reads
+    volatile float sink = 0.0f;
+
+    struct Result
+    {
+        std::string name;
+        size_t entities;
+        double nsPerOp;
+        double allocsPerOp;
+    };
+    std::vector<Result> results;
+
+    // setup() builds fresh state outside the timed region, run() is timed and does ops operations.
+    // Best of repetitions, allocations from the same run.
+    template<typename State, typename Setup, typename Run>
+    void Measure(const std::string& name, size_t entities, size_t ops, Setup&& setup, Run&& run, int repetitions = 5)
+    {
+        double bestNs = 0.0;
+        double allocs = 0.0;
+        for (int rep = 0; rep < repetitions; ++rep)
+        {
+            State state = setup();
+            const size_t allocsBefore = allocationCount.load(std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+            run(state);
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            const size_t allocsDuring = allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+            if (rep == 0 || ns < bestNs) {
+                bestNs = ns;
+                allocs = static_cast<double>(allocsDuring);
+            }
+        }
+        results.push_back({ name, entities, bestNs / ops, allocs / ops });
+        std::printf("%-32s %9zu  %10.2f ns/op  %8.3f allocs/op\n", name.c_str(), entities, bestNs / ops, allocs / ops);
+    }
+
+    // World plus the handles in it
+    struct Populated
+    {
+        std::unique_ptr<secs::World> world;
+        std::vector<secs::Entity> entities = {};
+    };
+
+    Populated Populate(size_t count, size_t components)
+    {
+        Populated p{ std::make_unique<secs::World>() };
+        p.entities = p.world->createEntities(count, FirstComponents(components));
+        return p;
+    }
+
+    // ============ Structural changes ============
+    void BenchStructural(size_t count)
+    {
+        const std::string suffix = "/" + std::to_string(count);
+        const int repetitions = count >= 1000000 ? 2 : 5;
+        auto empty = []() { return Populated{ std::make_unique<secs::World>() }; };
+        auto populated = [count]() { return Populate(count, 2); };
+
+        Measure<Populated>("create" + suffix, count, count, empty, [&](Populated& p) {
+            const std::vector<int> ids = FirstComponents(2);
+            for (size_t i = 0; i < count; ++i) p.world->createEntity(ids);
+        }, repetitions);
+
+        Measure<Populated>("create_bulk" + suffix, count, count, empty, [&](Populated& p) {
+            p.world->createEntities(count, C0{}, C1{});
+        }, repetitions);
+
+        Measure<Populated>("destroy" + suffix, count, count, populated, [&](Populated& p) {
+            for (secs::Entity e : p.entities) p.world->destroyEntity(e);
+        }, repetitions);
+
+        Measure<Populated>("destroy_bulk" + suffix, count, count, populated, [&](Populated& p) {
+            p.world->destroyEntities(p.entities);
+        }, repetitions);
+
+        Measure<Populated>("add_component" + suffix, count, count, populated, [&](Populated& p) {
+            for (secs::Entity e : p.entities) p.world->addComponent(e, C2{});
+        }, repetitions);
+
+        Measure<Populated>("remove_component" + suffix, count, count, [count]() { return Populate(count, 3); }, [&](Populated& p) {
+            for (secs::Entity e : p.entities) p.world->removeComponent<C2>(e);
+        }, repetitions);
+    }
+
+    // ============ Iteration ============
+    template<typename... Components>
+    void BenchIterate(size_t count)
+    {
+        constexpr size_t width = sizeof...(Components);
+        Populated p = Populate(count, width);
+        auto& query = p.world->query<Components...>();
+        // Warm the query cache outside the timing
+        query.forEachChunk([](const secs::Entity*, Components*..., size_t) {});
+
+        Measure<int>("iterate_" + std::to_string(width) + "_components", count, count, []() { return 0; }, [&](int&) {
+            float sum = 0.0f;
+            query.forEachChunk([&](const secs::Entity*, Components*... columns, size_t rows) {
+                for (size_t i = 0; i < rows; ++i) {
+                    sum += (columns[i].value[0] + ...);
+                }
+            });
+            sink = sum;
+        });
+    }
+
+    // Same number of entities, scattered over one archetype per subset of C1..C7
+    void BenchFragmented(size_t count)
+    {
+        Populated p{ std::make_unique<secs::World>() };
+        const size_t archetypes = 128;
+        for (size_t mask = 0; mask < archetypes; ++mask)
+        {
+            std::vector<int> ids = { componentIDs[0] };
+            for (size_t bit = 0; bit < 7; ++bit) {
+                if (mask & (size_t(1) << bit)) ids.push_back(componentIDs[bit + 1]);
+            }
+            p.world->createEntities(count / archetypes, ids);
+        }
+        auto& query = p.world->query<C0>();
+        Measure<int>("iterate_fragmented_128_archetypes", count, count, []() { return 0; }, [&](int&) {
+            float sum = 0.0f;
+            query.forEachChunk([&](const secs::Entity*, C0* c, size_t rows) {
+                for (size_t i = 0; i < rows; ++i) sum += c[i].value[0];
+            });
+            sink = sum;
+        });
+    }
+
+    // One field updated from another, whole structs vs one array per field
+    void BenchSplitFields(size_t count)
+    {
+        Populated aos = Populate(count, 1);
+        auto& structs = aos.world->query<C0>();
+        Measure<int>("update_field_struct_column", count, count, []() { return 0; }, [&](int&) {
+            structs.forEachChunk([](const secs::Entity*, C0* c, size_t rows) {
+                for (size_t i = 0; i < rows; ++i) c[i].value[0] += c[i].value[1];
+            });
+        });
+
+        Populated soa{ std::make_unique<secs::World>() };
+        soa.world->createEntities(count, SplitComponent{});
+        auto& fields = soa.world->query<secs::Split<SplitComponent>>();
+        Measure<int>("update_field_split_column", count, count, []() { return 0; }, [&](int&) {
+            fields.forEachChunk([](const secs::Entity*, secs::SplitColumn<SplitComponent> c, size_t rows) {
+                float* x       = c.get<&SplitComponent::x>();
+                const float* y = c.get<&SplitComponent::y>();
+                for (size_t i = 0; i < rows; ++i) x[i] += y[i];
+            });
+        });
+    }
+
+    // ============ Random access ============
+    void BenchRandomAccess(size_t count)
+    {
+        Populated p = Populate(count, 4);
+        std::vector<secs::Entity> shuffled = p.entities;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1234));
+
+        Measure<int>("get_component_random", count, count, []() { return 0; }, [&](int&) {
+            float sum = 0.0f;
+            for (secs::Entity e : shuffled) sum += p.world->getComponent<const C3>(e)->value[0];
+            sink = sum;
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string outputPath = "secs_benchmark.json";
+    bool quick = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quick") quick = true;
+        else outputPath = arg;
+    }
+
+    std::cout.setstate(std::ios::failbit); // Registration is chatty
+    RegisterComponents();
+    std::cout.clear();
+
+    std::vector<size_t> sizes = { 1000, 100000 };
+    if (!quick) sizes.push_back(1000000);
+    for (size_t count : sizes) {
+        BenchStructural(count);
+    }
+
+    const size_t iterationCount = quick ? 100000 : 1000000;
+    BenchIterate<C0>(iterationCount);
+    BenchIterate<C0, C1>(iterationCount);
+    BenchIterate<C0, C1, C2>(iterationCount);
+    BenchIterate<C0, C1, C2, C3>(iterationCount);
+    BenchIterate<C0, C1, C2, C3, C4>(iterationCount);
+    BenchIterate<C0, C1, C2, C3, C4, C5>(iterationCount);
+    BenchIterate<C0, C1, C2, C3, C4, C5, C6>(iterationCount);
+    BenchIterate<C0, C1, C2, C3, C4, C5, C6, C7>(iterationCount);
+    BenchFragmented(iterationCount);
+    BenchSplitFields(iterationCount);
+    BenchRandomAccess(quick ? 100000 : 1000000);
+
+    nlohmann::json report;
+    report["threads"] = JobSystem::Get().GetThreadCount();
+    for (const Result& r : results)
+    {
+        report["results"].push_back({
+            { "name", r.name },
+            { "entities", r.entities },
+            { "ns_per_op", r.nsPerOp },
+            { "allocs_per_op", r.allocsPerOp },
+        });
+    }
+    std::ofstream out(outputPath);
+    out << report.dump(2) << std::endl;
+    if (!out) {
+        std::cerr << "Couldn't write " << outputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << outputPath << std::endl;
+    return 0;
+}
@@ -86,4 +86,53 @@ project "PovertyEngine"
 		runtime "Release"
 		optimize "on"
 
+-- Headless ECS benchmark, only builds the bits of the engine that Secs.h needs
+project "SecsBenchmark"
+	location "SecsBenchmark"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "on"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+		"PovertyEngine/src/JobSystem.cpp",
+		"PovertyEngine/src/SecsAllocator.cpp"
+	}
+
+	includedirs
+	{
+		"PovertyEngine/src",
+		"%{IncludeDir.GLM}/",
+		"vendor/lohmann/"
+	}
+
+	defines
+	{
+		"PE_STATIC"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		defines "PE_DEBUG"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "PE_RELEASE"
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines "PE_DIST"
+		runtime "Release"
+		optimize "on"
+
 print(">>> povertyEngine premake loaded")